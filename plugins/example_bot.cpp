@@ -0,0 +1,133 @@
+/**
+ * example_bot.cpp
+ * poker
+ */
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include "PokerPlugin.h"
+
+/**
+ * a plugin bot, built as a shared object (poker_example_bot). plays its made hand:
+ * raises half the pot with two pair or better, calls with a pair, checks or folds
+ * otherwise, and draws to whatever it holds. args "raise=N" moves the raise
+ * threshold to class N on made_class()'s scale (2 is two pair).
+ * its decision count lives in host keep() memory, so it carries across reloads.
+ */
+
+struct ExampleShared {
+    std::atomic<uint64_t> decisions;
+    uint32_t builds;
+};
+static ExampleShared* shared = 0;
+static uint32_t build = 0;
+
+struct ExampleBot {
+    uint64_t seed;
+    int raise_class;
+};
+
+/* rough hand class from rank counts, enough for this bot: 0 high card, 1 pair,
+   2 two pair, 3 trips, 6 full house, 7 quads. ignores straights and flushes */
+static int made_class(PokerObservation const* obs, int* counts) {
+    for (int r = 0; r < 13; r++) counts[r] = 0;
+    for (size_t i = 0; i < obs->nhand; i++) counts[obs->hand[i] % 13]++;
+    int pairs = 0, trips = 0, quads = 0;
+    for (int r = 0; r < 13; r++) {
+        pairs += counts[r] == 2;
+        trips += counts[r] == 3;
+        quads += counts[r] == 4;
+    }
+    if (quads) return 7;
+    if (trips && pairs) return 6;
+    if (trips) return 3;
+    return pairs;
+}
+
+static int example_init(PokerPluginHost const* host) {
+    int fresh = 0;
+    shared = (ExampleShared*)host->keep("example_bot", sizeof(ExampleShared), &fresh);
+    if (!shared) return 1;
+    if (fresh) new (shared) ExampleShared();
+    build = ++shared->builds;
+    printf("example_bot: build %u up, %lu decisions so far\n", build, (unsigned long)shared->decisions.load());
+    return 0;
+}
+
+static void example_shutdown() {
+    printf("example_bot: build %u down\n", build);
+}
+
+static void* example_create(uint64_t seed, const char* args) {
+    ExampleBot* b = new (std::nothrow) ExampleBot();
+    if (!b) return 0;
+    b->seed = seed;
+    b->raise_class = 2;
+    if (args && !strncmp(args, "raise=", 6)) b->raise_class = atoi(args + 6);
+    return b;
+}
+
+static void example_destroy(void* bot) {
+    delete (ExampleBot*)bot;
+}
+
+static int example_bet(void* bot, PokerObservation const* obs, PokerPluginDecision* out) {
+    ExampleBot const& b = *(ExampleBot const*)bot;
+    shared->decisions.fetch_add(1, std::memory_order_relaxed);
+    int counts[13];
+    int made = made_class(obs, counts);
+    double owe = obs->bet - obs->seat_bet[obs->seat];
+    double inc = floor(obs->pot / 2.);
+    double raise_to = obs->bet + (inc < 1. ? 1. : inc);
+    if (made >= b.raise_class && raise_to - obs->seat_bet[obs->seat] < obs->stack[obs->seat]) {
+        out->action = ACTION_RAISE;
+        out->amount = raise_to;
+    } else if (owe <= 0.) {
+        out->action = ACTION_CHECK;
+    } else if (made >= 1 || obs->state == PokerFSM::BET_CHECK) {
+        out->action = ACTION_CALL;
+    } else {
+        out->action = ACTION_FOLD;
+    }
+    return 1;
+}
+
+static int example_discard(void* bot, PokerObservation const* obs, PokerPluginDecision* out) {
+    (void)bot;
+    shared->decisions.fetch_add(1, std::memory_order_relaxed);
+    int counts[13];
+    int made = made_class(obs, counts);
+    /* keep anything paired up, or the two highest cards with nothing */
+    int keep_over = 13;
+    if (!made) {
+        int seen = 0;
+        for (int r = 12; r >= 0 && seen < 2; r--) {
+            if (counts[r]) {seen += counts[r]; keep_over = r;}
+        }
+    }
+    out->discard = 0;
+    for (size_t i = 0; i < obs->nhand; i++) {
+        int r = obs->hand[i] % 13;
+        if (made ? counts[r] < 2 : r < keep_over) out->discard |= (uint8_t)(1u << i);
+    }
+    return 1;
+}
+
+static PokerPluginAPI const api = {
+    POKER_PLUGIN_ABI,
+    sizeof(PokerObservation),
+    "example_bot",
+    example_init,
+    example_shutdown,
+    example_create,
+    example_destroy,
+    example_bet,
+    example_discard,
+};
+
+extern "C" __attribute__((visibility("default"))) PokerPluginAPI const* poker_plugin_v1() {
+    return &api;
+}
@@ -1,25 +1,32 @@
 #version 410 core
 /*
- This is an example of a simple vertex shader
- The three options below are different levels of MVP matrix implementation
- The CPU calculates view and proj matricies from the position and type of the camera,
- and calculates the model matrix based on the transform (pos/rotation/scale) of the object.
+ Instanced card shader. The quad comes from the per vertex attributes,
+ where each card goes and what it shows come from the per instance ones
+ (CardInstance in CardInstances.h), so a whole table is one draw call.
  */
 layout (location = 0) in vec2 aPos;
 layout (location = 1) in vec2 aUV;
+layout (location = 2) in vec3 aInst;    // x, y, rotation in radians
+layout (location = 3) in uvec3 aCell;   // sheet x, sheet y, CARD_FACE_*
 
-uniform mat4 uModel;
 uniform mat4 uView;
 uniform mat4 uProj;
 
-uniform ivec2 uSheetPos;
-
 out vec2 iUV;
 out vec2 iPos;
 void main() {
     const vec2 card_size = vec2(1.f / 13.f, 1.f / 5.f);
-    iUV = (aUV + vec2(float(uSheetPos.x), float(uSheetPos.y))) * card_size;
+    const vec2 back = vec2(2.f, 0.f);
+    if (aCell.z == 2u) {
+        // CARD_HIDDEN: an unused slot, park it outside the clip volume
+        iUV = vec2(0.f); iPos = vec2(0.f);
+        gl_Position = vec4(2.f, 2.f, 2.f, 1.f);
+        return;
+    }
+    vec2 cell = aCell.z != 0u ? back : vec2(float(aCell.x), float(aCell.y));
+    iUV = (aUV + cell) * card_size;
     iPos = aPos;
-    gl_Position = uProj * uView * uModel * vec4(aPos, 0.f, 1.0f);
-    // gl_Position = uView * uModel * vec4(aPos, 0.f, 1.0f);
+    float c = cos(aInst.z), s = sin(aInst.z);
+    vec2 world = mat2(c, s, -s, c) * aPos + aInst.xy;
+    gl_Position = uProj * uView * vec4(world, 0.f, 1.0f);
 }
@@ -0,0 +1,56 @@
+#include "AllocCount.h"
+
+#ifdef POKER_COUNT_ALLOCS
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+/* thread_local with no constructor, it's touched from inside operator new */
+static thread_local AllocCounts mine = {0, 0, 0};
+static std::atomic<uint64_t> total_allocs{0}, total_frees{0}, total_bytes{0};
+
+static inline void* counted_alloc(size_t n, size_t align) {
+    mine.allocs++; mine.bytes += n;
+    total_allocs.fetch_add(1, std::memory_order_relaxed);
+    total_bytes.fetch_add(n, std::memory_order_relaxed);
+    if (!n) n = 1;
+    void* p = align > alignof(std::max_align_t) ? aligned_alloc(align, (n + align - 1) & ~(align - 1)) : malloc(n);
+    return p;
+}
+static inline void counted_free(void* p) {
+    if (!p) return;
+    mine.frees++;
+    total_frees.fetch_add(1, std::memory_order_relaxed);
+    free(p);
+}
+
+void* operator new(size_t n) {void* p = counted_alloc(n, 0); if (!p) throw std::bad_alloc(); return p;}
+void* operator new[](size_t n) {void* p = counted_alloc(n, 0); if (!p) throw std::bad_alloc(); return p;}
+void* operator new(size_t n, std::nothrow_t const&) noexcept {return counted_alloc(n, 0);}
+void* operator new[](size_t n, std::nothrow_t const&) noexcept {return counted_alloc(n, 0);}
+void* operator new(size_t n, std::align_val_t a) {void* p = counted_alloc(n, (size_t)a); if (!p) throw std::bad_alloc(); return p;}
+void* operator new[](size_t n, std::align_val_t a) {void* p = counted_alloc(n, (size_t)a); if (!p) throw std::bad_alloc(); return p;}
+void operator delete(void* p) noexcept {counted_free(p);}
+void operator delete[](void* p) noexcept {counted_free(p);}
+void operator delete(void* p, size_t) noexcept {counted_free(p);}
+void operator delete[](void* p, size_t) noexcept {counted_free(p);}
+void operator delete(void* p, std::align_val_t) noexcept {counted_free(p);}
+void operator delete[](void* p, std::align_val_t) noexcept {counted_free(p);}
+void operator delete(void* p, size_t, std::align_val_t) noexcept {counted_free(p);}
+void operator delete[](void* p, size_t, std::align_val_t) noexcept {counted_free(p);}
+
+AllocCounts alloc_counts() {return mine;}
+AllocCounts alloc_counts_total() {
+    return AllocCounts{total_allocs.load(std::memory_order_relaxed), total_frees.load(std::memory_order_relaxed), total_bytes.load(std::memory_order_relaxed)};
+}
+bool alloc_counting() {return true;}
+
+#else
+
+AllocCounts alloc_counts() {return AllocCounts{0, 0, 0};}
+AllocCounts alloc_counts_total() {return AllocCounts{0, 0, 0};}
+bool alloc_counting() {return false;}
+
+#endif /* POKER_COUNT_ALLOCS */
@@ -0,0 +1,28 @@
+/**
+ * AllocCount.h
+ * poker
+ */
+#ifndef ALLOC_COUNT_H
+#define ALLOC_COUNT_H
+#include <cstdint>
+
+/**
+ * global new/delete counters, build with -DPOKER_COUNT_ALLOCS.
+ * the flag replaces operator new and delete for the whole program with ones
+ * that count per thread (a plain increment) and then call malloc / free.
+ * take alloc_counts() before and after a region to see what it allocated.
+ * without the flag everything reads 0 and alloc_counting() is false.
+ */
+struct AllocCounts {
+    uint64_t allocs;
+    uint64_t frees;
+    uint64_t bytes;
+};
+
+/* the calling thread, since it started */
+AllocCounts alloc_counts();
+/* every thread, threads that exited included */
+AllocCounts alloc_counts_total();
+bool alloc_counting();
+
+#endif /* ALLOC_COUNT_H */
@@ -0,0 +1,48 @@
+#include "CardInstances.h"
+#include <cmath>
+
+void CardInstances::add(Card const& card, float x, float y, float rot, bool facedown) {
+    SheetCell cell = card_sheet_cell(card);
+    this->push_back(CardInstance{x, y, rot, cell.x, cell.y, (uint8_t)(facedown ? CARD_FACE_DOWN : CARD_FACE_UP), 0});
+}
+
+void CardInstances::add_deck(Deck const& deck, float x, float y, float spread, bool facedown) {
+    const float n = (float)deck.size();
+    size_t i = 0;
+    for (auto const& card : deck) {
+        add(card, x - (spread/2) + (((float)i * spread) / n), y, 0.f, facedown);
+        i++;
+    }
+}
+
+void table_pile_instances(TableSnapshot const& table, size_t pile, TableLayout const& at, CardInstance* out) {
+    const size_t slots = table_pile_slots(pile);
+    for (size_t i = 0; i < slots; i++)
+        out[i] = CardInstance{at.x, at.y, 0.f, SHEET_BACK_X, SHEET_BACK_Y, CARD_HIDDEN, 0};
+
+    if (pile == POKER_PILE_DECK) {
+        /* a squared up stack in the middle */
+        for (size_t i = 0; i < table.ndeck && i < slots; i++) {
+            out[i].x = at.x + 0.004f * (float)i;
+            out[i].y = at.y + 0.004f * (float)i;
+            out[i].face = CARD_FACE_DOWN;
+        }
+        return;
+    }
+    if (pile >= table.nseats) return;
+
+    /* viewer at the bottom, everyone else counter clockwise from there */
+    const float pi = 3.14159265f;
+    float angle = -pi / 2.f + 2.f * pi * (float)((pile + table.nseats - at.viewer) % table.nseats) / (float)table.nseats;
+    float cx = at.x + at.radius * cosf(angle), cy = at.y + at.radius * sinf(angle);
+    const bool showdown = table.state == PokerFSM::SHOW || table.state == PokerFSM::SHOW_ADV || table.state == PokerFSM::END;
+    const size_t n = table.ncards[pile] < slots ? table.ncards[pile] : slots;
+    const float spread = 2.5f;
+    for (size_t i = 0; i < n; i++) {
+        uint8_t c = table.cards[pile][i];
+        SheetCell cell = card_sheet_cell(card_from_index(c & ~TABLE_CARD_MARKED));
+        bool up = pile == at.viewer || (showdown && (c & TABLE_CARD_MARKED));
+        out[i] = CardInstance{cx - (spread/2) + (((float)i * spread) / (float)n), cy, 0.f,
+                              cell.x, cell.y, (uint8_t)(up ? CARD_FACE_UP : CARD_FACE_DOWN), 0};
+    }
+}
@@ -0,0 +1,67 @@
+/**
+ * CardInstances.h
+ * poker
+ */
+#ifndef CARD_INSTANCES_H
+#define CARD_INSTANCES_H
+#include <type_traits>
+#include "Deck.h"
+#include "TableSnapshot.h"
+
+/**
+ * the cpu half of instanced card drawing: a flat array of per card instance
+ * data that goes to the gpu as is. no gl in here, so it builds and runs anywhere.
+ */
+
+/* cell of a card in res/cards.png, see the layout table in the README */
+struct SheetCell {
+    uint8_t x, y;
+};
+static inline SheetCell card_sheet_cell(Card const& card) {
+    return SheetCell{(uint8_t)(((unsigned)card.rank + 1) % 13), (uint8_t)((unsigned)card.suit + 1)};
+}
+#define SHEET_BACK_X 2
+#define SHEET_BACK_Y 0
+
+#define CARD_FACE_UP 0
+#define CARD_FACE_DOWN 1    /* the shader swaps in the card back */
+#define CARD_HIDDEN 2       /* an unused slot, the shader drops it */
+
+/* one card on screen. layout matches the instance attributes in vert_cards.glsl */
+struct CardInstance {
+    float x, y;
+    float rot;          /* radians */
+    uint8_t cellx, celly;
+    uint8_t face;       /* CARD_FACE_* */
+    uint8_t _pad;
+};
+static_assert(sizeof(CardInstance) == 16 && std::is_trivially_copyable_v<CardInstance>, "uploaded as raw bytes");
+
+struct CardInstances : public std::vector<CardInstance> {
+    void add(Card const& card, float x, float y, float rot = 0.f, bool facedown = false);
+    /* fanned out like DeckRenderer::draw always has: spread wide, centered on x */
+    void add_deck(Deck const& deck, float x, float y, float spread, bool facedown = false);
+};
+
+/**
+ * a whole table in fixed instance slots: TABLE_SEAT_CARDS per seat, then the deck.
+ * every pile always owns the same slot range, so one that changed (its
+ * PokerState::version moved) can be rewritten on its own.
+ */
+#define TABLE_DECK_SLOTS 52
+#define TABLE_SLOTS (POKER_MAX_SEATS * TABLE_SEAT_CARDS + TABLE_DECK_SLOTS)
+
+struct TableLayout {
+    float x = 0.f, y = 0.f;     /* table center */
+    float radius = 2.5f;        /* seat hands sit on this circle */
+    uint8_t viewer = 0;         /* seat whose cards are face up, drawn at the bottom */
+    inline bool operator==(TableLayout const& o) const {return x == o.x && y == o.y && radius == o.radius && viewer == o.viewer;}
+};
+
+static inline size_t table_pile_first(size_t pile) {return pile * TABLE_SEAT_CARDS;}
+static inline size_t table_pile_slots(size_t pile) {return pile == POKER_PILE_DECK ? TABLE_DECK_SLOTS : TABLE_SEAT_CARDS;}
+
+/* writes exactly table_pile_slots(pile) instances, the unused ones CARD_HIDDEN */
+void table_pile_instances(TableSnapshot const& table, size_t pile, TableLayout const& at, CardInstance* out);
+
+#endif /* CARD_INSTANCES_H */
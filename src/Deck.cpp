@@ -1,4 +1,8 @@
 #include "Deck.h"
+#include "TextBuf.h"
+#include "PokerProfile.h"
+#include <cctype>
+#include <cstring>
 
 const char* rank_name(rank_e rank) {
     static const char* rank_names[] = {
@@ -39,8 +43,73 @@ const char* suit_name(suit_e suit) {
     return suit_names[suit];
 }
 
-void Card::print() {
-    lg("%s of %s", rank_name(this->rank), suit_name(this->suit));
+static const char card_rank_chars[RANK_LAST + 1] = "23456789TJQKA";
+static const char card_suit_chars[SUIT_LAST + 1] = "hdsc";
+
+/* char to rank / suit, 0xFF for anything else */
+struct CardTextTables {
+    uint8_t rank[256];
+    uint8_t suit[256];
+    CardTextTables() {
+        memset(rank, 0xFF, sizeof(rank));
+        memset(suit, 0xFF, sizeof(suit));
+        for (unsigned r = 0; r < RANK_LAST; r++) {
+            rank[(uint8_t)card_rank_chars[r]] = (uint8_t)r;
+            rank[(uint8_t)tolower(card_rank_chars[r])] = (uint8_t)r;
+        }
+        for (unsigned su = 0; su < SUIT_LAST; su++) {
+            suit[(uint8_t)card_suit_chars[su]] = (uint8_t)su;
+            suit[(uint8_t)toupper(card_suit_chars[su])] = (uint8_t)su;
+        }
+    }
+};
+static const CardTextTables card_text;
+
+void card_format(Card const& card, char* out) {
+    out[0] = card_rank_chars[card.rank];
+    out[1] = card_suit_chars[card.suit];
+}
+
+bool card_parse(const char* s, Card& out) {
+    uint8_t r = card_text.rank[(uint8_t)s[0]];
+    /* a terminator maps to 0xFF, so this never reads past the end */
+    uint8_t su = card_text.suit[(uint8_t)s[r == 0xFF ? 0 : 1]];
+    if ((r | su) & 0x80) return false;
+    out = Card{(rank_e)r, (suit_e)su, false};
+    return true;
+}
+
+size_t cards_format(Card const* cards, size_t n, char* out) {
+    char* at = out;
+    for (size_t i = 0; i < n; i++) {
+        card_format(cards[i], at);
+        at[2] = ' ';
+        at += 3;
+    }
+    if (at != out) at--;
+    *at = 0;
+    return (size_t)(at - out);
+}
+
+size_t cards_parse(const char* s, Card* out, size_t max) {
+    size_t n = 0;
+    while (n < max) {
+        while (*s == ' ') s++;
+        if (!card_parse(s, out[n])) break;
+        s += CARD_TEXT_LEN;
+        n++;
+        if (*s && *s != ' ') {n--; break;}
+    }
+    return n;
+}
+
+void Card::print() const {
+    TextBuf out; print(out);
+}
+
+void Card::print(TextBuf& out) const {
+    card_format(*this, out.reserve(CARD_TEXT_LEN));
+    out.commit(CARD_TEXT_LEN);
 }
 
 const char* hand_name(hand_e hand) {
@@ -59,7 +128,7 @@ const char* hand_name(hand_e hand) {
     return names[hand];
 }
 
-Deck::Deck(bool empty) {
+Deck::Deck(bool empty) : n(0) {
     if (empty) return;
     for (suit_e s = SUIT_HEARTS; s < SUIT_LAST; s = suit_next(s)) {
         for (rank_e r = RANK_2; r < RANK_LAST; r = rank_next(r)) {
@@ -68,22 +137,27 @@ Deck::Deck(bool empty) {
     }
 }
 
-size_t Deck::size() const {return this->std::vector<Card>::size();}
-
-std::vector<Card>::iterator Deck::begin() {
-    return this->std::vector<Card>::begin();
+/* only the live cards, a hand copies 5 not 52 */
+Deck::Deck(Deck const& other) : n(other.n) {
+    memcpy(cards, other.cards, n * sizeof(Card));
 }
 
-std::vector<Card>::iterator Deck::end() {
-    return this->std::vector<Card>::end();
+Deck& Deck::operator=(Deck const& other) {
+    n = other.n;
+    memmove(cards, other.cards, n * sizeof(Card));
+    return *this;
 }
 
-std::vector<Card>::const_iterator Deck::begin() const {
-    return this->std::vector<Card>::cbegin();
-}
+size_t Deck::size() const {return n;}
+
+Card* Deck::begin() {return cards;}
+Card* Deck::end() {return cards + n;}
+Card const* Deck::begin() const {return cards;}
+Card const* Deck::end() const {return cards + n;}
 
-std::vector<Card>::const_iterator Deck::end() const {
-    return this->std::vector<Card>::cend();
+void Deck::erase(size_t i) {
+    memmove(cards + i, cards + i + 1, (n - i - 1) * sizeof(Card));
+    n--;
 }
 
 Deck Deck::new_empty() {return Deck(true);}
@@ -91,13 +165,31 @@ Deck Deck::new_empty() {return Deck(true);}
 Deck Deck::new_deck() {return Deck();}
 
 Deck Deck::new_shuffled(uint32_t N) {
+    POKER_PROFILE(PROF_SHUFFLE);
     Deck deck;
     deck.shuffle(N);
     return deck;
 }
 
+Deck Deck::new_seeded(uint64_t seed) {
+    /* mt19937_64's output is pinned by the standard, the distributions aren't, so no std::uniform_* here */
+    POKER_PROFILE(PROF_SHUFFLE);
+    std::mt19937_64 rng(seed);
+    Deck deck;
+    for (size_t i = deck.size() - 1; i > 0; i--) {
+        deck.swap(i, (size_t)(rng() % (i + 1)));
+    }
+    return deck;
+}
+
+Deck Deck::from_indices(uint8_t const* idx, size_t n) {
+    Deck deck(true);
+    for (size_t i = 0; i < n; i++) deck.push_back(card_from_index(idx[i]));
+    return deck;
+}
+
 void Deck::swap(size_t a, size_t b) {
-    assert(a < this->size() && b < this->size());
+    POKER_DCHECK(a < this->size() && b < this->size());
     if (a == b) return;
     Card t = this->at(a);
     (*this)[a] = (*this)[b];
@@ -105,12 +197,9 @@ void Deck::swap(size_t a, size_t b) {
 }
 
 Card Deck::remove(size_t i) {
-    assert(i < this->size());
+    POKER_DCHECK(i < this->size());
     Card res = this->at(i);
-    for (size_t j = i; j < this->size() - 1; j++) {
-        this->swap(j, j+1);
-    }
-    this->pop_back();
+    this->erase(i);
     return res;
 }
 
@@ -145,7 +234,7 @@ Card Deck::draw_random() {
         return Card{RANK_LAST,SUIT_LAST,false};
     }
     Card res = this->at(idx);
-    this->erase(std::next(this->begin(), idx));
+    this->erase(idx);
     return res;
 }
 
@@ -248,6 +337,30 @@ void Deck::mark(size_t i, bool mk) const {
 }
 
 hand_e Deck::find_best_hand() const {
+    return ::find_best_hand(this->data(), this->size());
+}
+
+uint32_t Deck::strength() const {
+    return hand_strength(this->data(), this->size());
+}
+
+uint32_t hand_strength(Card const* cards, size_t n) {
+    if (!n) return 0;
+    uint8_t count[RANK_LAST] = {0};
+    for (size_t i = 0; i < n; i++) count[cards[i].rank]++;
+    /* class in the top bits, then 5 rank nibbles (rank + 1, 0 pads short hands) */
+    uint32_t res = (uint32_t)find_best_hand(cards, n);
+    size_t packed = 0;
+    for (size_t c = 5; c > 0; c--) {
+        for (size_t r = RANK_LAST; r-- > 0;) {
+            if (count[r] != c) continue;
+            for (size_t k = 0; k < c && packed < 5; k++, packed++) res = (res << 4) | (uint32_t)(r + 1);
+        }
+    }
+    return res << (STRENGTH_RANK_BITS - 4 * packed);
+}
+
+hand_e find_best_hand(Card const* cards, size_t n) {
     hand_e power = HAND_HIGHCARD;
 
     uint32_t suit_ctr[SUIT_LAST] = {0};
@@ -256,7 +369,8 @@ hand_e Deck::find_best_hand() const {
         uint32_t suitmap;
     } rank_ctr[RANK_LAST] = {0,0};
 
-    for (auto card : *this) {
+    for (size_t i = 0; i < n; i++) {
+        Card const& card = cards[i];
         suit_ctr[card.suit]++;
         if (suit_ctr[card.suit] > 4) {
             power = better_hand(power, HAND_FLUSH);
@@ -315,9 +429,15 @@ hand_e Deck::find_best_hand() const {
 }
 
 void Deck::print() const {
-    for (auto card : *this) {
-        card.print(); lg("\n");
+    TextBuf out; print(out);
+}
+
+void Deck::print(TextBuf& out) const {
+    for (size_t i = 0; i < this->size(); i++) {
+        if (i) out.put(' ');
+        (*this)[i].print(out);
     }
+    out.put('\n');
 }
 
 
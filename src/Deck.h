@@ -7,6 +7,8 @@
 #define DECK_H
 #include "util.h"
 
+struct TextBuf;
+
 typedef enum {
     RANK_2 = 0,
     RANK_3,
@@ -66,13 +68,37 @@ struct Card {
     rank_e rank;
     suit_e suit;
     mutable bool mark;
-    void print();
+    void print() const;
+    void print(TextBuf& out) const;
 };
 
 bool inline operator==(Card const& a, Card const& b) {
     return a.rank == b.rank && a.suit == b.suit;
 }
 
+/* dense 0-51 card index for fixed layout records (suit major) */
+static inline uint8_t card_index(Card const& card) {
+    return (uint8_t)(((unsigned)card.suit) * 13 + ((unsigned)card.rank));
+}
+static inline Card card_from_index(uint8_t idx) {
+    return Card{(rank_e)(idx % 13), (suit_e)(idx / 13), false};
+}
+
+/**
+ * short card text, rank then suit: "Qh", "Ts", "2c". ranks 23456789TJQKA,
+ * suits hdsc. both directions are table lookups with no branches per card,
+ * parse takes either case.
+ */
+#define CARD_TEXT_LEN 2
+/* writes CARD_TEXT_LEN chars, no terminator */
+void card_format(Card const& card, char* out);
+/* the first CARD_TEXT_LEN chars of s. false (and out untouched) if they aren't a card */
+bool card_parse(const char* s, Card& out);
+/* space separated and terminated, out needs 3 * n + 1 bytes. returns the length */
+size_t cards_format(Card const* cards, size_t n, char* out);
+/* space separated cards until the end of s or max, returns how many. stops at anything that isn't one */
+size_t cards_parse(const char* s, Card* out, size_t max);
+
 typedef enum {
     HAND_HIGHCARD = 0,
     HAND_PAIR,
@@ -98,18 +124,38 @@ static inline hand_e better_hand(hand_e a, hand_e b) {
     return a > b ? a : b;
 }
 
-struct Deck : private std::vector<Card> {
+/* evaluators over raw card arrays, Deck forwards to these */
+hand_e find_best_hand(Card const* cards, size_t n);
+/* showdown order: hand class, then ranks by how many of each, then how high
+   (pairs before kickers). higher is better, equal only when hands split */
+uint32_t hand_strength(Card const* cards, size_t n);
+/* the hand class sits above the 5 rank nibbles */
+#define STRENGTH_RANK_BITS 20
+static inline hand_e strength_hand(uint32_t strength) {
+    return (hand_e)(strength >> STRENGTH_RANK_BITS);
+}
+
+#define DECK_MAX 52
+
+/* the cards live inline, making, copying and dealing decks never touches the heap */
+struct Deck {
     Deck(bool empty = false);
+    Deck(Deck const& other);
+    Deck& operator=(Deck const& other);
 
     size_t size() const;
-    std::vector<Card>::iterator begin();
-    std::vector<Card>::iterator end();
-    std::vector<Card>::const_iterator begin() const;
-    std::vector<Card>::const_iterator end() const;
+    Card* begin();
+    Card* end();
+    Card const* begin() const;
+    Card const* end() const;
 
     static Deck new_empty();
     static Deck new_deck();
     static Deck new_shuffled(uint32_t N = 2048);
+    /* same order for the same seed on every platform and thread, for replays */
+    static Deck new_seeded(uint64_t seed);
+    /* cards from card_index()es, in order */
+    static Deck from_indices(uint8_t const* idx, size_t n);
     static Deck new_hand(hand_e hand);
 
     void swap(size_t a, size_t b);
@@ -136,9 +182,27 @@ struct Deck : private std::vector<Card> {
     void mark(size_t i, bool mark = true) const;
 
     hand_e find_best_hand() const;
+    uint32_t strength() const;
     
+    /* one line, "Qh Ts 2c 4d 9s" */
     void print() const;
-    
+    void print(TextBuf& out) const;
+
+private:
+    uint32_t n;
+    Card cards[DECK_MAX];
+    /* the bits of std::vector the implementation leans on */
+    inline void push_back(Card c) {POKER_DCHECK(n < DECK_MAX); if (n < DECK_MAX) cards[n++] = c;}
+    inline void pop_back() {POKER_DCHECK(n > 0); if (n) n--;}
+    inline Card& back() {POKER_DCHECK(n > 0); return cards[n ? n - 1 : 0];}
+    inline Card const& back() const {POKER_DCHECK(n > 0); return cards[n ? n - 1 : 0];}
+    inline Card& at(size_t i) {return cards[i];}
+    inline Card const& at(size_t i) const {return cards[i];}
+    inline Card& operator[](size_t i) {return cards[i];}
+    inline Card const& operator[](size_t i) const {return cards[i];}
+    inline bool empty() const {return !n;}
+    inline Card const* data() const {return cards;}
+    void erase(size_t i);
 };
 
 struct DeckSet {
@@ -147,9 +211,9 @@ struct DeckSet {
     Deck const options;
     size_t const N;
     struct DeckSetIterator {
-        std::vector<Card>::const_iterator it;
+        Card const* it;
         DeckSet* home;
-        inline DeckSetIterator(DeckSet* h, std::vector<Card>::const_iterator const& in) : it(in), home(h) {}
+        inline DeckSetIterator(DeckSet* h, Card const* in) : it(in), home(h) {}
         inline DeckSetIterator& operator++() {++it; return *this;}
         inline Deck operator*() const {
             Deck res = home->deck; res.add(*it); return res;
@@ -1,14 +1,17 @@
 #include "Driver.h"
+#include "Trace.h"
 #include <cmath>
 #include <flgl/logger.h>
 #include <flgl.h>
 LOG_MODULE(driver);
 using namespace glm;
 
-#define COMPLICATED_LOOP 0
-
 Driver::Driver() :  _close(false),
                             _dt(1.f/60.f),
+                            _step(1.f/60.f),
+                            _max_steps(5),
+                            _acc(0.f),
+                            _alpha(0.f),
                             cam(0),
                             _launch_timer(SECONDS),
                             delta_timer(SECONDS)
@@ -40,9 +43,16 @@ static Stopwatch t_upd(MICROSECONDS);
 static Stopwatch t_ren(MICROSECONDS);
 #endif /* BENCHMARK */
 
+void Driver::set_timestep(float step, unsigned max_steps) {
+    _step = step > 0.f ? step : 1.f/60.f;
+    _max_steps = max_steps ? max_steps : 1;
+    _frames.target = _step;
+    _acc = 0.f;
+}
 
-#define min(x,y) ((x)<(y)?(x):(y))
 void Driver::loop() {
+    TRACE_POLL();
+    TRACE_ZONE("frame", "driver");
 
 #ifdef BENCHMARK
     static float tu[32]; 
@@ -51,23 +61,35 @@ void Driver::loop() {
     t_upd.reset_start();
 #endif /* BENCHMARK */
 
-#if COMPLICATED_LOOP == 1
-    if (_dt > 1.f/30.f) {
-        while (_dt > 0.f) {
-            user_update(min(_dt, 1.f/60.f), window.keyboard, window.mouse);
-            _dt -= 1.f/60.f;
+    {
+        TRACE_ZONE("user_frame", "driver");
+        user_frame(_dt, window.keyboard, window.mouse);
+    }
+    {
+        /* fixed steps for whatever time the last frame took, at most _max_steps of them.
+           past that the game slows down instead of spiraling, the rest is dropped */
+        TRACE_ZONE("user_update", "driver");
+        _acc += _dt;
+        unsigned n = 0;
+        for (; _acc >= _step && n < _max_steps; n++) {
+            user_update(_step, window.keyboard, window.mouse);
+            _acc -= _step;
         }
-    } else {
-        user_update(_dt, window.keyboard, window.mouse);
+        if (_acc >= _step) {
+            uint64_t behind = (uint64_t)(_acc / _step);
+            _frames.skipped_steps += behind;
+            _acc -= (float)behind * _step;
+        }
+        _alpha = _acc / _step;
     }
-#else 
-    user_update(_dt, window.keyboard, window.mouse);
-#endif /* COMPLICATED_LOOP */
 #ifdef BENCHMARK
     tu[(t)&0x1F] = t_upd.stop();
     t_ren.reset_start();
 #endif /* BENCHMARK */
-    user_render();
+    {
+        TRACE_ZONE("user_render", "driver");
+        user_render();
+    }
 
 #ifdef BENCHMARK
 
@@ -90,12 +112,15 @@ void Driver::loop() {
     }
 #endif /* BENCHMARK */
 
-    window.update();
+    {
+        TRACE_ZONE("window.update", "driver");
+        window.update();
+    }
 
     _dt = delta_timer.stop_reset_start();
-    if (std::isinf(_dt) || std::isnan(_dt)){
-        _dt = 1.f / 80.f; //TODO: hate this...
-    }
+    /* a broken timer reading counts as one on time frame */
+    if (!std::isfinite(_dt) || _dt < 0.f) _dt = _step;
+    _frames.record(_dt);
 }
 
 void Driver::start() {
@@ -106,6 +131,7 @@ void Driver::start() {
        loop();
     }
     LOG_INF("out of loop, exiting...");
+    _frames.report();
     exit();
 }
 
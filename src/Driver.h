@@ -11,6 +11,7 @@
 #include <flgl.h>
 #include <flgl/tools.h>
 #include "Stopwatch.h"
+#include "FrameStats.h"
 
 /* usage: DRIVER_MAIN_FUNCTION(main, <name of your implementation>); */
 #define DRIVER_MAIN_FUNCTION(main_name, Classname) int main_name() {Classname *driver = new Classname(); driver->start(); delete driver; return 0;}
@@ -27,15 +28,30 @@ public:
     inline float dt() const {return _dt;};
     inline Stopwatch const& launch_timer() {return _launch_timer;}
 
+    /* user_update() runs every step seconds, catching up at most max_steps per frame */
+    void set_timestep(float step, unsigned max_steps = 5);
+    inline float timestep() const {return _step;}
+    /* how far into the next step this frame is, [0, 1). render at lerp(prev, cur, alpha) */
+    inline float alpha() const {return _alpha;}
+    inline FrameStats const& frame_stats() const {return _frames;}
+
     glm::vec2 world_mouse(glm::vec2 mp, Camera* camovr = 0) const;
 
 private:
 	bool _close;
 	float _dt;
+    float _step;
+    unsigned _max_steps;
+    float _acc;
+    float _alpha;
+    FrameStats _frames;
     const Camera* cam;
 	Stopwatch _launch_timer;
     Stopwatch delta_timer;
     virtual void user_create() = 0;
+    /* once per frame with the real dt, before the steps. input edges belong here, a frame can run no steps */
+    virtual void user_frame(float dt, Keyboard const& kb, Mouse const& mouse) {(void)dt; (void)kb; (void)mouse;}
+    /* zero or more times per frame, always with dt = timestep() */
     virtual void user_update(float dt, Keyboard const& kb, Mouse const& mouse) = 0;
     virtual void user_render() = 0;
     virtual void user_destroy() = 0;
@@ -0,0 +1,30 @@
+#include "FrameStats.h"
+#include "util.h"
+#include <algorithm>
+
+void FrameStats::record(float seconds) {
+    ring[frames % FRAME_STATS_RING] = seconds;
+    frames++;
+    if (seconds > FRAME_STATS_DROP * target) dropped++;
+}
+
+float FrameStats::percentile(double q) const {
+    size_t n = frames < FRAME_STATS_RING ? (size_t)frames : FRAME_STATS_RING;
+    if (!n) return 0.f;
+    float sorted[FRAME_STATS_RING];
+    std::copy(ring, ring + n, sorted);
+    size_t at = (size_t)(q * (double)(n - 1) + 0.5);
+    if (at >= n) at = n - 1;
+    std::nth_element(sorted, sorted + at, sorted + n);
+    return sorted[at];
+}
+
+void FrameStats::reset() {
+    frames = dropped = skipped_steps = 0;
+}
+
+void FrameStats::report() const {
+    lg("frames: %lu, p50 %.2fms p95 %.2fms p99 %.2fms, %lu dropped, %lu steps skipped\n",
+       (unsigned long)frames, p50() * 1000.f, p95() * 1000.f, p99() * 1000.f,
+       (unsigned long)dropped, (unsigned long)skipped_steps);
+}
@@ -0,0 +1,37 @@
+/**
+ * FrameStats.h
+ * poker
+ */
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+#include <cstdint>
+#include <cstddef>
+
+#define FRAME_STATS_RING 512
+/* a frame this many targets long counts as dropped */
+#define FRAME_STATS_DROP 1.5f
+
+/**
+ * frame pacing numbers, no gl so headless runs can assert on them.
+ * the last FRAME_STATS_RING frame times go in a ring for percentiles,
+ * the counters cover every frame since the last reset().
+ */
+struct FrameStats {
+    float target = 1.f / 60.f;      /* seconds, what a frame should take */
+    uint64_t frames = 0;
+    uint64_t dropped = 0;           /* frames over FRAME_STATS_DROP * target */
+    uint64_t skipped_steps = 0;     /* fixed steps thrown away when catch up ran out of budget */
+
+    void record(float seconds);
+    /* seconds at q in [0, 1] over the ring, 0 before the first frame */
+    float percentile(double q) const;
+    inline float p50() const {return percentile(0.50);}
+    inline float p95() const {return percentile(0.95);}
+    inline float p99() const {return percentile(0.99);}
+    void reset();
+    void report() const;
+private:
+    float ring[FRAME_STATS_RING];
+};
+
+#endif /* FRAME_STATS_H */
@@ -0,0 +1,238 @@
+#include "HandHistory.h"
+#include "TextBuf.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ *  HandHistoryWriter
+ */
+
+HandHistoryWriter::HandHistoryWriter(FILE* f, size_t buffer_bytes, uint64_t first)
+    : hands(0), bytes(0), file(f), buffer(buffer_bytes), used(0), first_id(first), open_hand(false) {
+    memset(&hand, 0, sizeof(hand));
+}
+
+HandHistoryWriter::HandHistoryWriter() : HandHistoryWriter(0, 0) {}
+
+HandHistoryWriter* HandHistoryWriter::open(const char* path, size_t buffer_bytes) {
+    const size_t max_hand = sizeof(HandRecord) + HH_MAX_EVENTS * sizeof(HandEvent);
+    if (buffer_bytes < max_hand) buffer_bytes = max_hand;
+
+    HandFileHeader want = {HH_FILE_MAGIC, HH_VERSION, sizeof(HandRecord), sizeof(HandEvent)};
+    uint64_t first_id = 0;
+    FILE* existing = fopen(path, "rb");
+    if (existing) {
+        HandFileHeader have;
+        size_t got = fread(&have, sizeof(have), 1, existing);
+        fseek(existing, 0, SEEK_END);
+        long size = ftell(existing);
+        if (size > 0 && (got != 1 || memcmp(&have, &want, sizeof(want)))) {
+            PLOG_ERROR("ERROR: %s isn't a v%d hand history, not appending to it\n", path, HH_VERSION);
+            fclose(existing);
+            return 0;
+        }
+        /* count the hands already there, skipping over their events */
+        HandRecord rec;
+        fseek(existing, sizeof(have), SEEK_SET);
+        while (fread(&rec, sizeof(rec), 1, existing) == 1 && rec.magic == HH_HAND_MAGIC) {
+            first_id++;
+            if (fseek(existing, (long)rec.nevents * (long)sizeof(HandEvent), SEEK_CUR)) break;
+        }
+        fclose(existing);
+    }
+    FILE* f = fopen(path, "ab");
+    if (!f) {PLOG_ERROR("ERROR: can't open %s for writing\n", path); return 0;}
+    fseek(f, 0, SEEK_END);
+    if (ftell(f) == 0 && fwrite(&want, sizeof(want), 1, f) != 1) {
+        PLOG_ERROR("ERROR: can't write to %s\n", path);
+        fclose(f);
+        return 0;
+    }
+    return new HandHistoryWriter(f, buffer_bytes, first_id);
+}
+
+HandHistoryWriter::~HandHistoryWriter() {
+    if (!file) return;
+    flush();
+    fclose(file);
+}
+
+bool HandHistoryWriter::flush() {
+    if (!used || !file) return true;
+    bool ok = fwrite(buffer.data(), 1, used, file) == used;
+    if (!ok) PLOG_ERROR("ERROR: hand history write failed, %zu bytes lost\n", used);
+    bytes += used;
+    used = 0;
+    return ok;
+}
+
+void HandHistoryWriter::begin(PokerState const& game, uint64_t seed) {
+    memset(&hand, 0, sizeof(hand));
+    hand.magic = HH_HAND_MAGIC;
+    hand.nseats = (uint8_t)game.players.size();
+    hand.rounds = (uint8_t)game.round;
+    hand.id = first_id + hands;
+    hand.seed = seed;
+    for (size_t i = 0; i < game.players.size() && i < POKER_MAX_SEATS; i++)
+        hand.stack[i] = (double)game.players[i].stack;
+    size_t n = 0;
+    for (auto c : game.deck) {
+        if (n == 52) break;
+        hand.deck[n++] = card_index(c);
+    }
+    open_hand = true;
+}
+
+HandEvent& HandHistoryWriter::push(hhEvent_e type, size_t seat, size_t round) {
+    /* past the cap events are dropped and the hand is flagged, nothing real gets near it */
+    HandEvent* slot = &spill;
+    if (hand.nevents < HH_MAX_EVENTS) slot = &events[hand.nevents++];
+    else hand.flags |= HH_TRUNCATED;
+    HandEvent& e = *slot;
+    memset(&e, 0, sizeof(e));
+    e.type = (uint8_t)type;
+    e.seat = (uint8_t)seat;
+    e.round = (uint8_t)round;
+    return e;
+}
+
+static void event_cards(HandEvent& e, Deck const& cards) {
+    for (auto c : cards) {
+        if (e.ncards == 5) break;
+        e.cards[e.ncards++] = card_index(c);
+    }
+}
+
+void HandHistoryWriter::deal(size_t seat, Deck const& cards) {
+    if (!open_hand) return;
+    HandEvent& e = push(HH_DEAL, seat, hand.rounds);
+    event_cards(e, cards);
+}
+
+void HandHistoryWriter::bet(PokerState const& game, pokerAction_e kind, size_t seat) {
+    if (!open_hand) return;
+    HandEvent& e = push(HH_BET, seat, game.round);
+    PokerPlayer const& p = game.players.get(seat);
+    e.kind = (uint8_t)kind;
+    e.amount = (double)p.bet;
+    e.stack = (double)p.stack;
+}
+
+void HandHistoryWriter::discard(PokerState const& game, size_t seat, uint8_t mask) {
+    if (!open_hand) return;
+    HandEvent& e = push(HH_DISCARD, seat, game.round);
+    e.mask = mask;
+    event_cards(e, game.players.get(seat).hand);
+}
+
+void HandHistoryWriter::show(PokerState const& game, size_t seat) {
+    if (!open_hand) return;
+    HandEvent& e = push(HH_SHOW, seat, game.round);
+    event_cards(e, game.players.get(seat).hand.get_marked());
+}
+
+void HandHistoryWriter::end(PokerState const& game, size_t winner, Money const* won) {
+    if (!open_hand) return;
+    for (size_t i = 0; i < game.players.size(); i++) {
+        if (won[i] <= 0.) continue;
+        HandEvent& e = push(HH_END, i, 0);
+        e.amount = (double)won[i];
+        e.stack = (double)game.players.get(i).stack;
+    }
+    hand.winner = (uint8_t)winner;
+    hand.pot = (double)game.pot;
+
+    hands++;
+    open_hand = false;
+    if (!file) return;
+
+    const size_t need = sizeof(HandRecord) + hand.nevents * sizeof(HandEvent);
+    if (used + need > buffer.size()) flush();
+    memcpy(buffer.data() + used, &hand, sizeof(HandRecord));
+    memcpy(buffer.data() + used + sizeof(HandRecord), events, hand.nevents * sizeof(HandEvent));
+    used += need;
+}
+
+/**
+ *  HandHistoryReader
+ */
+
+HandHistoryReader::HandHistoryReader(uint8_t const* d, size_t l) : data(d), len(l) {}
+
+HandHistoryReader* HandHistoryReader::open(const char* path) {
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {PLOG_ERROR("ERROR: can't open %s\n", path); return 0;}
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(HandFileHeader)) {
+        PLOG_ERROR("ERROR: %s is too short to be a hand history\n", path);
+        close(fd);
+        return 0;
+    }
+    size_t len = (size_t)st.st_size;
+    void* mem = mmap(0, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {PLOG_ERROR("ERROR: mmap(%s) failed\n", path); return 0;}
+    madvise(mem, len, MADV_SEQUENTIAL);
+
+    HandFileHeader const* h = (HandFileHeader const*)mem;
+    if (h->magic != HH_FILE_MAGIC || h->version != HH_VERSION
+        || h->hand_size != sizeof(HandRecord) || h->event_size != sizeof(HandEvent)) {
+        PLOG_ERROR("ERROR: %s isn't a v%d hand history\n", path, HH_VERSION);
+        munmap(mem, len);
+        return 0;
+    }
+    return new HandHistoryReader((uint8_t const*)mem, len);
+}
+
+HandHistoryReader::~HandHistoryReader() {
+    munmap((void*)data, len);
+}
+
+/* at if a whole, sane hand starts there, otherwise stop */
+static uint8_t const* hh_check(uint8_t const* at, uint8_t const* stop) {
+    if ((size_t)(stop - at) < sizeof(HandRecord)) return stop;
+    HandRecord const* h = (HandRecord const*)at;
+    if (h->magic != HH_HAND_MAGIC || h->nevents > HH_MAX_EVENTS) return stop;
+    if ((size_t)(stop - at) < sizeof(HandRecord) + h->nevents * sizeof(HandEvent)) return stop;
+    return at;
+}
+
+HandHistoryReader::iterator& HandHistoryReader::iterator::operator++() {
+    HandRecord const* h = (HandRecord const*)at;
+    at = hh_check(at + sizeof(HandRecord) + h->nevents * sizeof(HandEvent), stop);
+    return *this;
+}
+
+HandHistoryReader::iterator HandHistoryReader::begin() const {
+    return iterator{hh_check(data + sizeof(HandFileHeader), data + len), data + len};
+}
+
+HandHistoryReader::iterator HandHistoryReader::end() const {
+    return iterator{data + len, data + len};
+}
+
+/**
+ *  HandView
+ */
+
+void HandView::print(TextBuf& out) const {
+    static const char* names[HH_LAST] = {"deal", "bet", "discard", "show", "end"};
+    out.fmt("hand %lu: %u seats, pot %.2f, seat %u wins%s\n", (unsigned long)hand->id, hand->nseats, hand->pot, hand->winner,
+            hand->flags & HH_TRUNCATED ? " (truncated)" : "");
+    for (HandEvent const& e : *this) {
+        out.fmt("  %-7s seat %u round %u", e.type < HH_LAST ? names[e.type] : "?", e.seat, e.round);
+        if (e.type == HH_BET) out.fmt(" %s to %.2f (%.2f left)", action_name((pokerAction_e)e.kind), e.amount, e.stack);
+        if (e.type == HH_DISCARD) out.fmt(" mask %02x", e.mask);
+        if (e.type == HH_END) out.fmt(" takes %.2f (%.2f left)", e.amount, e.stack);
+        for (size_t i = 0; i < e.ncards && i < 5; i++) {
+            char* at = out.reserve(1 + CARD_TEXT_LEN);
+            at[0] = ' ';
+            card_format(card_from_index(e.cards[i]), at + 1);
+            out.commit(1 + CARD_TEXT_LEN);
+        }
+        out.put('\n');
+    }
+}
@@ -0,0 +1,153 @@
+/**
+ * HandHistory.h
+ * poker
+ */
+#ifndef HAND_HISTORY_H
+#define HAND_HISTORY_H
+#include <type_traits>
+#include "PokerGame.h"
+
+/**
+ * append only binary hand histories.
+ * a file is a HandFileHeader then hands back to back. a hand is one HandRecord
+ * followed by its nevents HandEvents. everything is fixed size, 8 byte aligned and
+ * host endian, so a mapped file is read in place.
+ */
+
+#define HH_FILE_MAGIC 0x48484b50 /* PKHH */
+#define HH_HAND_MAGIC 0x444e4148 /* HAND, lets a reader resync or spot garbage */
+#define HH_VERSION 3
+#define HH_MAX_EVENTS 256
+
+/* HandRecord::flags */
+#define HH_TRUNCATED 0x01   /* the hand ran past HH_MAX_EVENTS, the rest wasn't logged */
+
+typedef enum {
+    HH_DEAL = 0,        /* seat was dealt cards[] */
+    HH_BET,             /* seat acted: kind, amount = their bet after, stack after */
+    HH_DISCARD,         /* mask = positions thrown from the old hand, cards[] = the hand after the draw */
+    HH_SHOW,            /* cards[] = the marked cards the seat showed */
+    HH_END,             /* one per seat paid at the end: amount = its take, stack after */
+    HH_LAST,
+} hhEvent_e;
+
+struct HandFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t hand_size;     /* sizeof(HandRecord) */
+    uint32_t event_size;    /* sizeof(HandEvent) */
+};
+
+struct HandRecord {
+    uint32_t magic;
+    uint16_t nevents;
+    uint8_t nseats;
+    uint8_t rounds;
+    uint64_t id;            /* place in the file, counting hands earlier writers appended */
+    uint64_t seed;          /* what the deck was shuffled from, 0 if unknown */
+    double stack[POKER_MAX_SEATS];  /* at the deal */
+    uint8_t deck[52];       /* card_index() in Deck order at the deal, the top is the last one */
+    uint8_t winner;         /* the best hand, HH_END events have every seat's take */
+    uint8_t flags;
+    uint8_t _pad[2];
+    double pot;
+};
+
+struct HandEvent {
+    uint8_t type;           /* hhEvent_e */
+    uint8_t seat;
+    uint8_t kind;           /* pokerAction_e, HH_BET only */
+    uint8_t round;
+    uint8_t cards[5];
+    uint8_t ncards;
+    uint8_t mask;
+    uint8_t _pad;
+    uint32_t _reserved;
+    double amount;
+    double stack;
+};
+
+static_assert(sizeof(HandFileHeader) == 16, "hand history layout changed, bump HH_VERSION");
+static_assert(sizeof(HandRecord) == 136, "hand history layout changed, bump HH_VERSION");
+static_assert(sizeof(HandEvent) == 32, "hand history layout changed, bump HH_VERSION");
+static_assert(std::is_trivially_copyable_v<HandRecord> && std::is_trivially_copyable_v<HandEvent>, "written as raw bytes");
+
+/* one hand, pointing into a mapping or a writer */
+struct HandView {
+    HandRecord const* hand;
+    HandEvent const* events;
+    inline HandEvent const* begin() const {return events;}
+    inline HandEvent const* end() const {return events + hand->nevents;}
+    /* one line per event, cards as "Qh" */
+    void print(TextBuf& out) const;
+};
+
+/**
+ * buffered writer. PokerGame calls it from its exec_ functions when
+ * PokerGame::recorder is set; a hand is assembled in place and copied into the
+ * output buffer at END, which goes to disk in big blocks.
+ * one writer per thread, it isn't synchronized.
+ */
+struct HandHistoryWriter {
+    /* appends if the file exists, ids carry on from the hands already in it. 0 on failure */
+    static HandHistoryWriter* open(const char* path, size_t buffer_bytes = 1 << 20);
+    /* no file, only keeps the latest hand around for last() */
+    HandHistoryWriter();
+    ~HandHistoryWriter();
+
+    void begin(PokerState const& game, uint64_t seed = 0);
+    void deal(size_t seat, Deck const& hand);
+    void bet(PokerState const& game, pokerAction_e kind, size_t seat);
+    void discard(PokerState const& game, size_t seat, uint8_t mask);
+    void show(PokerState const& game, size_t seat);
+    /* won is every seat's take from settle_pots() */
+    void end(PokerState const& game, size_t winner, Money const* won);
+
+    bool flush();
+    /* the hand in progress, or the one that just ended */
+    inline HandView last() const {return HandView{&hand, events};}
+    uint64_t hands;         /* written by this writer */
+    uint64_t bytes;
+private:
+    HandHistoryWriter(FILE* f, size_t buffer_bytes, uint64_t first_id = 0);
+    HandEvent& push(hhEvent_e type, size_t seat, size_t round);
+    FILE* file;
+    std::vector<uint8_t> buffer;
+    size_t used;
+    uint64_t first_id;      /* hands in the file before this writer opened it */
+    HandRecord hand;
+    HandEvent events[HH_MAX_EVENTS];
+    HandEvent spill;        /* takes the events past HH_MAX_EVENTS */
+    bool open_hand;
+};
+
+/**
+ * maps a whole history file read only and walks it without copying.
+ * iteration stops early at a torn or corrupt tail (a writer that died mid flush).
+ */
+struct HandHistoryReader {
+    /* 0 on failure */
+    static HandHistoryReader* open(const char* path);
+    ~HandHistoryReader();
+
+    struct iterator {
+        uint8_t const* at;
+        uint8_t const* stop;
+        inline HandView operator*() const {
+            HandRecord const* h = (HandRecord const*)at;
+            return HandView{h, (HandEvent const*)(at + sizeof(HandRecord))};
+        }
+        iterator& operator++();
+        inline bool operator!=(iterator const& other) const {return at != other.at;}
+    };
+    iterator begin() const;
+    iterator end() const;
+
+    size_t size_bytes() const {return len;}
+private:
+    HandHistoryReader(uint8_t const* data, size_t len);
+    uint8_t const* data;
+    size_t len;
+};
+
+#endif /* HAND_HISTORY_H */
@@ -0,0 +1,163 @@
+#include "HandReplay.h"
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* a hand that somehow never ends is a mismatch, not a hang */
+#define REPLAY_MAX_STEPS 100000
+#define REPLAY_BATCH 1024
+
+/**
+ *  ReplayScript
+ */
+
+ReplayScript::ReplayScript(HandView const& l) : log(l), diverged(false) {
+    memset(cursor, 0, sizeof(cursor));
+}
+
+HandEvent const* ReplayScript::next(size_t seat, hhEvent_e type) {
+    if (seat >= POKER_MAX_SEATS) {diverged = true; return 0;}
+    for (uint16_t i = cursor[seat]; i < log.hand->nevents; i++) {
+        HandEvent const& e = log.events[i];
+        if (e.seat != seat || e.type == HH_DEAL || e.type == HH_END) continue;
+        if (e.type != type) break;
+        cursor[seat] = i + 1;
+        return &e;
+    }
+    diverged = true;
+    return 0;
+}
+
+/**
+ *  ReplayController
+ */
+
+ReplayController::ReplayController(ReplayScript& s) : PokerPlayerController(), script(s) {}
+
+PokerBetAction* ReplayController::bet(PokerObservation const& obs, PokerPlayer const& player) {
+    HandEvent const* e = script.next(player.index, HH_BET);
+    if (!e || e->kind >= ACTION_LAST) {
+        /* off script, keep the hand legal so it still ends and the compare reports where */
+        return obs.bet == obs.seat_bet[obs.seat] ? new_bet_action(ACTION_CHECK, player.index) : new_bet_action(ACTION_FOLD, player.index);
+    }
+    return new_bet_action((pokerAction_e)e->kind, player.index, (Money)e->amount);
+}
+
+PokerPlayerController::ControlResult ReplayController::discard(PokerObservation const& obs, PokerPlayer const& player) {
+    (void)obs;
+    HandEvent const* e = script.next(player.index, HH_DISCARD);
+    if (!e) return CONTROL_OK;
+    for (size_t i = 0; i < player.hand.size(); i++) {
+        if (e->mask & (1u << i)) player.hand.mark(i);
+    }
+    return CONTROL_OK;
+}
+
+PokerPlayerController::ControlResult ReplayController::show(PokerObservation const& obs, PokerPlayer const& player) {
+    HandEvent const* e = script.next(player.index, HH_SHOW);
+    if (!e) return PokerPlayerController::show(obs, player);
+    player.hand.mark_all(false);
+    for (size_t i = 0; i < e->ncards; i++) {
+        size_t at = player.hand.find(card_from_index(e->cards[i]));
+        if (at < player.hand.size()) player.hand.mark(at);
+        else script.diverged = true;
+    }
+    return CONTROL_OK;
+}
+
+/**
+ *  replay
+ */
+
+ReplayOutcome replay_hand(HandView const& log) {
+    HandRecord const& rec = *log.hand;
+    if (rec.nseats < 2 || rec.nseats > POKER_MAX_SEATS) return ReplayOutcome{false, -1};
+    /* the log ran out before the hand did */
+    if (rec.flags & HH_TRUNCATED) return ReplayOutcome{false, (int32_t)rec.nevents};
+
+    ReplayScript script(log);
+    PlayerList players;
+    for (size_t s = 0; s < rec.nseats; s++) players.add(new ReplayController(script), (Money)rec.stack[s]);
+    /* a seeded hand re-shuffles, which checks Deck::new_seeded() against the logged deck too */
+    Deck deck = rec.seed ? Deck::new_seeded(rec.seed) : Deck::from_indices(rec.deck, 52);
+    PokerGame game(players, rec.rounds, deck);
+    game.seed = rec.seed;
+    HandHistoryWriter scratch;
+    game.recorder = &scratch;
+
+    size_t steps = 0;
+    while (game.step().status != PokerGame::Result::END) {
+        if (++steps > REPLAY_MAX_STEPS) return ReplayOutcome{false, (int32_t)rec.nevents};
+    }
+
+    /* events first, the first one that differs says more than the outcome in the record */
+    HandView got = scratch.last();
+    size_t n = got.hand->nevents < rec.nevents ? got.hand->nevents : rec.nevents;
+    for (size_t i = 0; i < n; i++) {
+        if (memcmp(&got.events[i], &log.events[i], sizeof(HandEvent)) != 0) return ReplayOutcome{false, (int32_t)i};
+    }
+    if (got.hand->nevents != rec.nevents || script.diverged) return ReplayOutcome{false, (int32_t)n};
+    HandRecord want = rec;
+    want.id = got.hand->id;
+    if (memcmp(&want, got.hand, sizeof(HandRecord)) != 0) return ReplayOutcome{false, -1};
+    return ReplayOutcome{true, 0};
+}
+
+struct ReplayShared {
+    std::mutex lock;
+    HandHistoryReader::iterator at, stop;
+    std::atomic<uint64_t> reported;
+    size_t max_report;
+};
+
+static void replay_worker(ReplayShared* shared, ReplayStats* out) {
+    HandRecord const* batch[REPLAY_BATCH];
+    for (;;) {
+        size_t n = 0;
+        {
+            /* handing out batches only touches record headers, the replays run unlocked */
+            std::lock_guard<std::mutex> guard(shared->lock);
+            for (; n < REPLAY_BATCH && shared->at != shared->stop; ++shared->at)
+                batch[n++] = (*shared->at).hand;
+        }
+        if (!n) return;
+        for (size_t i = 0; i < n; i++) {
+            HandView v{batch[i], (HandEvent const*)(batch[i] + 1)};
+            ReplayOutcome r = replay_hand(v);
+            out->hands++;
+            out->events += v.hand->nevents;
+            if (r.ok) continue;
+            out->mismatches++;
+            if (shared->reported.fetch_add(1) < shared->max_report)
+                lg("replay mismatch: hand %lu at event %d\n", (unsigned long)v.hand->id, r.event);
+        }
+    }
+}
+
+ReplayStats replay_corpus(HandHistoryReader const& reader, size_t threads, size_t max_report) {
+    if (!threads) threads = 1;
+    auto start = std::chrono::steady_clock::now();
+    ReplayShared shared;
+    shared.at = reader.begin();
+    shared.stop = reader.end();
+    shared.reported = 0;
+    shared.max_report = max_report;
+
+    std::vector<ReplayStats> stats(threads);
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < threads; t++) workers.emplace_back(replay_worker, &shared, &stats[t]);
+    replay_worker(&shared, &stats[0]);
+    for (auto& w : workers) w.join();
+
+    ReplayStats total;
+    for (auto& s : stats) {
+        total.hands += s.hands;
+        total.events += s.events;
+        total.mismatches += s.mismatches;
+    }
+    total.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return total;
+}
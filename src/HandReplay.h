@@ -0,0 +1,53 @@
+/**
+ * HandReplay.h
+ * poker
+ */
+#ifndef HAND_REPLAY_H
+#define HAND_REPLAY_H
+#include "HandHistory.h"
+
+/**
+ * re-executes logged hands through a real PokerGame.
+ * every seat gets a ReplayController that answers bet/discard/show from the log,
+ * the game deals from the logged seed (or the logged deck when there's no seed),
+ * and the hand it records is compared with the one in the log, byte for byte.
+ */
+
+/* shared by all the seats of one hand */
+struct ReplayScript {
+    ReplayScript(HandView const& log);
+    HandView log;
+    uint16_t cursor[POKER_MAX_SEATS];   /* per seat, next event to look at */
+    bool diverged;                      /* someone was asked for a decision the log doesn't have */
+    /* the seat's next decision if it is a type, 0 (and diverged) otherwise */
+    HandEvent const* next(size_t seat, hhEvent_e type);
+};
+
+struct ReplayController : public PokerPlayerController {
+    ReplayController(ReplayScript& script);
+    virtual PokerBetAction* bet(PokerObservation const& obs, PokerPlayer const& player) override final;
+    virtual ControlResult discard(PokerObservation const& obs, PokerPlayer const& player) override final;
+    virtual ControlResult show(PokerObservation const& obs, PokerPlayer const& player) override final;
+private:
+    ReplayScript& script;
+};
+
+struct ReplayOutcome {
+    bool ok;
+    int32_t event;      /* first event that differs, -1 for the HandRecord, nevents if one log is longer or truncated */
+};
+
+ReplayOutcome replay_hand(HandView const& log);
+
+struct ReplayStats {
+    uint64_t hands = 0;
+    uint64_t events = 0;
+    uint64_t mismatches = 0;
+    double seconds = 0.;
+    inline double hands_per_sec() const {return seconds > 0. ? (double)hands / seconds : 0.;}
+};
+
+/* replays a whole file on threads, logs the first max_report mismatching hand ids */
+ReplayStats replay_corpus(HandHistoryReader const& reader, size_t threads = 1, size_t max_report = 8);
+
+#endif /* HAND_REPLAY_H */
@@ -0,0 +1,104 @@
+#include "Log.h"
+#include "TextBuf.h"
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+#define PLOG_LINE 512
+/* how long the writer naps when the ring is empty */
+#define PLOG_IDLE_US 1000
+
+/* bounded mpsc ring, a sequence number per slot says whose turn it is (vyukov) */
+static PlogSlot ring[PLOG_RING];
+alignas(64) static std::atomic<size_t> enqueue_at{0};
+alignas(64) static size_t dequeue_at = 0;
+static std::atomic<uint64_t> dropped{0};
+
+/* one consumer at a time, the writer thread or whoever calls plog_flush() */
+static std::mutex drain_lock;
+static std::atomic<bool> running{false};
+static std::thread writer;
+static std::once_flag started;
+
+static bool drain(TextBuf& out) {
+    bool any = false;
+    char line[PLOG_LINE];
+    for (;;) {
+        PlogSlot& slot = ring[dequeue_at & (PLOG_RING - 1)];
+        if (slot.seq.load(std::memory_order_acquire) != dequeue_at + 1) break;
+        slot.format(slot.args, line, sizeof(line));
+        slot.seq.store(dequeue_at + PLOG_RING, std::memory_order_release);
+        dequeue_at++;
+        out.put(line);
+        any = true;
+    }
+    return any;
+}
+
+static void writer_loop() {
+    TextBuf out(stderr);
+    while (running.load(std::memory_order_relaxed)) {
+        bool any;
+        {
+            std::lock_guard<std::mutex> guard(drain_lock);
+            /* flushed under the lock so a plog_flush() never gets ahead of us */
+            any = drain(out);
+            out.flush();
+        }
+        if (!any) std::this_thread::sleep_for(std::chrono::microseconds(PLOG_IDLE_US));
+    }
+}
+
+static void stop() {
+    running.store(false);
+    if (writer.joinable()) writer.join();
+    plog_flush();
+}
+
+static void start() {
+    for (size_t i = 0; i < PLOG_RING; i++) ring[i].seq.store(i, std::memory_order_relaxed);
+    running.store(true);
+    writer = std::thread(writer_loop);
+    atexit(stop);
+}
+
+PlogSlot* plog_claim(size_t& ticket) {
+    std::call_once(started, start);
+    size_t at = enqueue_at.load(std::memory_order_relaxed);
+    for (;;) {
+        PlogSlot& slot = ring[at & (PLOG_RING - 1)];
+        intptr_t dif = (intptr_t)slot.seq.load(std::memory_order_acquire) - (intptr_t)at;
+        if (dif == 0) {
+            if (enqueue_at.compare_exchange_weak(at, at + 1, std::memory_order_relaxed)) {
+                ticket = at;
+                return &slot;
+            }
+        } else if (dif < 0) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return 0;
+        } else {
+            at = enqueue_at.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void plog_commit(PlogSlot* slot, size_t ticket) {
+    slot->seq.store(ticket + 1, std::memory_order_release);
+    /* after exit nobody is draining, write it now */
+    if (!running.load(std::memory_order_relaxed)) plog_flush();
+}
+
+void plog_flush() {
+    std::lock_guard<std::mutex> guard(drain_lock);
+    TextBuf out(stderr);
+    drain(out);
+}
+
+void plog_format_text(void const* p, char* out, size_t n) {
+    snprintf(out, n, "%s", (char const*)p);
+}
+
+uint64_t plog_dropped() {
+    return dropped.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,151 @@
+/**
+ * Log.h
+ * poker
+ */
+#ifndef POKER_LOG_H
+#define POKER_LOG_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <new>
+#include <type_traits>
+
+/**
+ * leveled async logging. PLOG_DEBUG/INFO/WARN/ERROR below PLOG_LEVEL compile
+ * to nothing (the format is still type checked). the rest copy the format
+ * pointer and the arguments into a slot of a lock free ring and return, a
+ * background thread does the formatting and the writing to stderr.
+ * arguments are copied as bytes, except that a log with a string argument is
+ * formatted on the spot into the slot instead (cut to PLOG_ARGS bytes), so
+ * strings needn't outlive the call. a full ring drops the message and counts
+ * it, a log call never waits. plog_flush() writes out everything logged so far.
+ *
+ * POKER_CHECK(expr) is always evaluated and logs on failure. POKER_DCHECK(expr)
+ * only exists in -DPOKER_DEBUG builds, otherwise expr isn't even evaluated.
+ */
+
+#define PLOG_LEVEL_DEBUG 0
+#define PLOG_LEVEL_INFO 1
+#define PLOG_LEVEL_WARN 2
+#define PLOG_LEVEL_ERROR 3
+#define PLOG_LEVEL_OFF 4
+#ifndef PLOG_LEVEL
+#define PLOG_LEVEL PLOG_LEVEL_INFO
+#endif
+
+#define PLOG_RING 2048          /* slots, a power of 2 */
+#define PLOG_ARGS 240           /* bytes of format pointer + arguments, or of text, a slot holds */
+
+typedef void (*plog_format_f)(void const* args, char* out, size_t n);
+
+struct PlogSlot {
+    std::atomic<size_t> seq;
+    plog_format_f format;
+    alignas(16) unsigned char args[PLOG_ARGS];
+};
+
+/* a slot to fill and the ticket to commit it with, 0 when the ring is full */
+PlogSlot* plog_claim(size_t& ticket);
+void plog_commit(PlogSlot* slot, size_t ticket);
+void plog_flush();
+/* messages lost to a full ring so far */
+uint64_t plog_dropped();
+
+/* the arguments as nested plain structs, unlike a tuple that stays trivially copyable */
+template <typename... A> struct PlogPack;
+template <> struct PlogPack<> {};
+template <typename H, typename... R> struct PlogPack<H, R...> {
+    H head;
+    PlogPack<R...> tail;
+    inline PlogPack(H const& h, R const&... r) : head(h), tail(r...) {}
+};
+
+template <typename... A>
+struct PlogArgs {
+    const char* fmt;
+    PlogPack<A...> values;
+};
+
+template <typename... A>
+static int plog_format_into(char* out, size_t n, const char* fmt, A const&... xs) {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-security"
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+    return snprintf(out, n, fmt, xs...);
+#pragma GCC diagnostic pop
+}
+
+template <typename P, typename... Done>
+static void plog_unpack(char* out, size_t n, const char* fmt, P const& pack, Done const&... done) {
+    if constexpr (std::is_empty_v<P>) plog_format_into(out, n, fmt, done...);
+    else plog_unpack(out, n, fmt, pack.tail, done..., pack.head);
+}
+
+template <typename... A>
+static void plog_format(void const* p, char* out, size_t n) {
+    PlogArgs<A...> const& a = *(PlogArgs<A...> const*)p;
+    plog_unpack(out, n, a.fmt, a.values);
+}
+
+/* a slot already formatted at the log call */
+void plog_format_text(void const* p, char* out, size_t n);
+
+template <typename T>
+inline constexpr bool plog_is_str = std::is_same_v<T, const char*> || std::is_same_v<T, char*>;
+
+template <typename... A>
+static inline void plog(const char* fmt, A... args) {
+    static_assert((std::is_trivially_copyable_v<A> && ...), "log arguments are copied as bytes");
+    static_assert(sizeof(PlogArgs<A...>) <= PLOG_ARGS, "too many log arguments for one slot");
+    size_t ticket;
+    PlogSlot* slot = plog_claim(ticket);
+    if (!slot) return;
+    if constexpr ((plog_is_str<A> || ...)) {
+        /* the string may be gone by the time the writer gets here, keep the text */
+        char* text = (char*)slot->args;
+        if (plog_format_into(text, PLOG_ARGS, fmt, args...) >= PLOG_ARGS) text[PLOG_ARGS - 2] = '\n';
+        slot->format = &plog_format_text;
+    } else {
+        slot->format = &plog_format<A...>;
+        new (slot->args) PlogArgs<A...>{fmt, PlogPack<A...>(args...)};
+    }
+    plog_commit(slot, ticket);
+}
+
+/* never called, lets the compiler check formats of disabled logs too */
+static inline void plog_check(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+static inline void plog_check(const char* fmt, ...) {(void)fmt;}
+
+#define PLOG_ON(...) do {if (0) plog_check(__VA_ARGS__); plog(__VA_ARGS__);} while (0)
+#define PLOG_OFF(...) do {if (0) plog_check(__VA_ARGS__);} while (0)
+
+#if PLOG_LEVEL <= PLOG_LEVEL_DEBUG
+#define PLOG_DEBUG(...) PLOG_ON(__VA_ARGS__)
+#else
+#define PLOG_DEBUG(...) PLOG_OFF(__VA_ARGS__)
+#endif
+#if PLOG_LEVEL <= PLOG_LEVEL_INFO
+#define PLOG_INFO(...) PLOG_ON(__VA_ARGS__)
+#else
+#define PLOG_INFO(...) PLOG_OFF(__VA_ARGS__)
+#endif
+#if PLOG_LEVEL <= PLOG_LEVEL_WARN
+#define PLOG_WARN(...) PLOG_ON(__VA_ARGS__)
+#else
+#define PLOG_WARN(...) PLOG_OFF(__VA_ARGS__)
+#endif
+#if PLOG_LEVEL <= PLOG_LEVEL_ERROR
+#define PLOG_ERROR(...) PLOG_ON(__VA_ARGS__)
+#else
+#define PLOG_ERROR(...) PLOG_OFF(__VA_ARGS__)
+#endif
+
+#define POKER_CHECK(expr) do {if (!(expr)) PLOG_ERROR("ERROR: ASSERTION FAILED!!! %s (%s:%d)\n", #expr, __FILE__, __LINE__);} while (0)
+#ifdef POKER_DEBUG
+#define POKER_DCHECK(expr) POKER_CHECK(expr)
+#else
+#define POKER_DCHECK(expr) do {(void)sizeof(!(expr));} while (0)
+#endif
+
+#endif /* POKER_LOG_H */
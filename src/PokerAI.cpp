@@ -1,13 +1,252 @@
 #include "PokerAI.h"
+#include <thread>
+#include <chrono>
+#include <cmath>
+#include <vector>
 
+typedef std::chrono::steady_clock mcts_clock;
 
+absBet_e rollout_bet(uint8_t legal, std::mt19937_64& rng) {
+    static const uint32_t weights[ABS_LAST] = {8, 24, 7, 1};
+    uint32_t tot = 0;
+    for (size_t a = 0; a < ABS_LAST; a++) if (legal & (1u << a)) tot += weights[a];
+    uint32_t r = (uint32_t)(rng() % tot);
+    for (size_t a = 0; a < ABS_LAST; a++) {
+        if (!(legal & (1u << a))) continue;
+        if (r < weights[a]) return (absBet_e)a;
+        r -= weights[a];
+    }
+    return ABS_CALL;
+}
+
+static void snapshot_default_discard(PokerSnapshot& snap) {
+    PokerSnapshot::Seat const& s = snap.seats[snap.turn];
+    snap.apply(PokerSnapshotAction{0, default_discard(s.hand, s.nhand), 0.});
+}
+
+/**
+ *  MCTS
+ */
+
+struct MCTSNode {
+    uint32_t child;     /* first child, 0 until expanded */
+    uint8_t nchild;
+    uint8_t action;     /* absBet_e, or the discard mask under a discard root */
+    uint8_t mover;      /* seat that took action */
+    uint32_t visits;
+    double value;       /* sum of the movers reward */
+};
+
+struct MCTSJob {
+    PokerObservation const* obs;
+    uint8_t const* unseen;
+    size_t nunseen;
+    uint8_t const* root_discards;
+    size_t ndiscards;
+    MCTSConfig const* cfg;
+    mcts_clock::time_point deadline;
+    uint64_t seed;
+    /* out */
+    std::vector<MCTSNode> tree;
+    uint64_t playouts;
+};
+
+static void mcts_expand(MCTSJob& job, uint32_t at, PokerSnapshot const& snap, bool discard_root) {
+    uint32_t first = (uint32_t)job.tree.size();
+    uint8_t n = 0;
+    if (discard_root) {
+        for (; n < job.ndiscards; n++)
+            job.tree.push_back(MCTSNode{0, 0, job.root_discards[n], (uint8_t)snap.turn, 0, 0.});
+    } else {
+        uint8_t legal = abs_legal(snap);
+        for (uint8_t a = 0; a < ABS_LAST; a++) {
+            if (!(legal & (1u << a))) continue;
+            job.tree.push_back(MCTSNode{0, 0, a, (uint8_t)snap.turn, 0, 0.});
+            n++;
+        }
+    }
+    job.tree[at].child = first;
+    job.tree[at].nchild = n;
+}
+
+static uint32_t mcts_select(MCTSJob& job, uint32_t at, PokerSnapshot const& snap, bool discard_root, std::mt19937_64& rng) {
+    MCTSNode const& parent = job.tree[at];
+    uint8_t legal = discard_root ? 0xFF : abs_legal(snap);
+    double logn = log((double)(parent.visits + 1));
+    uint32_t best = 0; double best_score = -1e300;
+    for (uint32_t c = parent.child; c < parent.child + parent.nchild; c++) {
+        MCTSNode const& ch = job.tree[c];
+        if (!discard_root && !(legal & (1u << ch.action))) continue;
+        double score = ch.visits
+            ? ch.value / ch.visits + job.cfg->explore * sqrt(logn / ch.visits)
+            : 1e200 + (double)(rng() & 0xFFFF);
+        if (score > best_score) {best_score = score; best = c;}
+    }
+    return best;
+}
+
+static void mcts_run(MCTSJob* pjob) {
+    MCTSJob& job = *pjob;
+    std::mt19937_64 rng(job.seed);
+    PokerObservation const& obs = *job.obs;
+    const bool discard_decision = obs.state == PokerFSM::DISCARD;
+    const bool timed = job.cfg->budget_ms > 0.;
+
+    double scale = obs.pot;
+    for (size_t i = 0; i < obs.nseats; i++) scale += obs.stack[i];
+    if (scale <= 0.) scale = 1.;
+
+    std::vector<uint8_t> hidden(job.unseen, job.unseen + job.nunseen);
+    std::vector<uint32_t> path;
+    job.tree.clear();
+    job.tree.reserve(timed ? 1u << 16 : job.cfg->iterations * 2 + 8);
+    job.tree.push_back(MCTSNode{0, 0, 0, obs.seat, 0, 0.});
+    job.playouts = 0;
+
+    for (uint64_t it = 0; ; it++) {
+        if (timed) {
+            if (!(it & 31) && mcts_clock::now() >= job.deadline) break;
+        } else if (it >= job.cfg->iterations) break;
+
+        for (size_t i = hidden.size(); i > 1; i--) {
+            size_t j = rng() % i;
+            uint8_t t = hidden[i-1]; hidden[i-1] = hidden[j]; hidden[j] = t;
+        }
+        PokerSnapshot snap = PokerSnapshot::determinize(obs, hidden.data(), hidden.size());
+
+        /* selection + expansion */
+        uint32_t at = 0;
+        path.clear(); path.push_back(0);
+        while (!snap.over()) {
+            bool discard_root = at == 0 && discard_decision;
+            if (snap.state == PokerFSM::DISCARD && !discard_root) {
+                snapshot_default_discard(snap);
+                continue;
+            }
+            bool fresh = job.tree[at].nchild == 0;
+            if (fresh) mcts_expand(job, at, snap, discard_root);
+            uint32_t c = mcts_select(job, at, snap, discard_root, rng);
+            if (!c) break;
+            uint8_t action = job.tree[c].action;
+            snap.apply(discard_root ? PokerSnapshotAction{0, action, 0.} : abs_to_snapshot(snap, (absBet_e)action));
+            path.push_back(c);
+            at = c;
+            if (fresh || job.tree[c].visits == 0) break;
+        }
+
+        /* rollout */
+        while (!snap.over()) {
+            if (snap.state == PokerFSM::DISCARD) snapshot_default_discard(snap);
+            else snap.apply(abs_to_snapshot(snap, rollout_bet(abs_legal(snap), rng)));
+        }
 
-PokerBetAction* BasicAIPlayer::bet(PokerState const &game, PokerPlayer const &player) {
-    return 0;
+        /* backup, each node scores for the seat that moved into it */
+        for (uint32_t n : path) {
+            MCTSNode& node = job.tree[n];
+            node.visits++;
+            node.value += (double)(snap.seats[node.mover].stack - obs.stack[node.mover]) / scale;
+        }
+        job.playouts++;
+    }
 }
 
-PokerPlayerController::ControlResult BasicAIPlayer::discard(PokerState const &game, PokerPlayer const &player) {
+/**
+ *  BasicAIPlayer
+ */
+
+BasicAIPlayer::BasicAIPlayer(MCTSConfig cfg) : PokerPlayerController(), config(cfg), rng(cfg.seed ? cfg.seed : std::random_device()()) {
+    if (!config.threads) config.threads = 1;
+}
+
+/* observations carry no hand number. a new hand starts the rounds over and the history
+   short, and never deals a card back into the hand that threw it away */
+void BasicAIPlayer::forget_discards(PokerObservation const& obs) {
+    bool stale = obs.round > discard_round || obs.nhistory < discard_history;
+    for (size_t d = 0; !stale && d < ndiscarded; d++)
+        for (size_t i = 0; i < obs.nhand; i++) stale |= obs.hand[i] == discarded[d];
+    if (stale) ndiscarded = 0;
+}
+
+size_t BasicAIPlayer::search(PokerObservation const& obs, uint8_t const* root_discards, size_t ndiscards) {
+    bool seen[52] = {false};
+    for (size_t i = 0; i < obs.nhand; i++) seen[obs.hand[i]] = true;
+    for (size_t d = 0; d < ndiscarded; d++) seen[discarded[d]] = true;
+    uint8_t unseen[52]; size_t nunseen = 0;
+    for (uint8_t c = 0; c < 52; c++) if (!seen[c]) unseen[nunseen++] = c;
+
+    mcts_clock::time_point start = mcts_clock::now();
+    std::vector<MCTSJob> jobs(config.threads);
+    for (auto& job : jobs) {
+        job.obs = &obs;
+        job.unseen = unseen; job.nunseen = nunseen;
+        job.root_discards = root_discards; job.ndiscards = ndiscards;
+        job.cfg = &config;
+        job.deadline = start + std::chrono::microseconds((int64_t)(config.budget_ms * 1000.));
+        job.seed = rng();
+    }
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < jobs.size(); t++) workers.emplace_back(mcts_run, &jobs[t]);
+    mcts_run(&jobs[0]);
+    for (auto& w : workers) w.join();
+
+    /* root parallel: every tree expands the root the same way, so children line up */
+    MCTSNode const& root = jobs[0].tree[0];
+    size_t best = 0; uint64_t best_visits = 0;
+    last = SearchStats();
+    for (size_t c = 0; c < root.nchild; c++) {
+        uint64_t visits = 0;
+        for (auto& job : jobs) {
+            if (job.tree[0].nchild == root.nchild) visits += job.tree[job.tree[0].child + c].visits;
+        }
+        if (visits > best_visits) {best_visits = visits; best = c;}
+    }
+    for (auto& job : jobs) last.playouts += job.playouts;
+    last.decisions = 1;
+    last.seconds = std::chrono::duration<double>(mcts_clock::now() - start).count();
+    total.decisions++; total.playouts += last.playouts; total.seconds += last.seconds;
+    if (config.verbose) {
+        lg("mcts seat %u: %lu playouts in %.2fms on %zu threads, %.0f playouts/sec\n",
+           obs.seat, (unsigned long)last.playouts, last.seconds * 1000., config.threads, last.playouts_per_sec());
+    }
+    return root.nchild ? jobs[0].tree[root.child + best].action : 0;
+}
+
+PokerBetAction* BasicAIPlayer::bet(PokerObservation const& obs, PokerPlayer const& player) {
+    (void)player;
+    forget_discards(obs);
+    return abs_to_action(obs, (absBet_e)search(obs, 0, 0));
+}
+
+PokerPlayerController::ControlResult BasicAIPlayer::discard(PokerObservation const& obs, PokerPlayer const& player) {
+    uint8_t cands[DISCARD_MAX_CANDIDATES];
+    size_t n = discard_candidates(obs.hand, obs.nhand, cands);
+    forget_discards(obs);
+    uint8_t mask = n > 1 ? (uint8_t)search(obs, cands, n) : cands[0];
+    for (size_t i = 0; i < obs.nhand; i++) {
+        if (!(mask & (1u << i))) continue;
+        player.hand.mark(i);
+        if (ndiscarded < 52) discarded[ndiscarded++] = obs.hand[i];
+    }
+    discard_round = obs.round;
+    discard_history = obs.nhistory;
     return CONTROL_OK;
 }
 
+/**
+ *  RandomAIPlayer
+ */
+
+RandomAIPlayer::RandomAIPlayer(uint64_t seed) : PokerPlayerController(), rng(seed ? seed : std::random_device()()) {}
 
+PokerBetAction* RandomAIPlayer::bet(PokerObservation const& obs, PokerPlayer const& player) {
+    (void)player;
+    return abs_to_action(obs, rollout_bet(abs_legal(obs), rng));
+}
+
+PokerPlayerController::ControlResult RandomAIPlayer::discard(PokerObservation const& obs, PokerPlayer const& player) {
+    uint8_t mask = default_discard(obs.hand, obs.nhand, player.best_hand());
+    for (size_t i = 0; i < obs.nhand; i++) {
+        if (mask & (1u << i)) player.hand.mark(i);
+    }
+    return CONTROL_OK;
+}
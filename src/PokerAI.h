@@ -1,16 +1,67 @@
-/** 
- * PokerAI.h 
+/**
+ * PokerAI.h
  * poker
  * created 03/22/25 by frank collebrusco
  */
 #ifndef POKER_AI_H
 #define POKER_AI_H
+#include <random>
 #include "PokerGame.h"
+#include "PokerAbstraction.h"
 
+struct MCTSConfig {
+    size_t threads = 1;         /* independent root trees, merged by visit count */
+    size_t iterations = 2000;   /* per thread, per decision. ignored if budget_ms > 0 */
+    double budget_ms = 0.;      /* wall time per decision */
+    double explore = 0.7;       /* UCT exploration constant, rewards are a fraction of the chips at the table */
+    uint64_t seed = 0;          /* 0 seeds from the os */
+    bool verbose = false;       /* log throughput after every decision */
+};
+
+struct SearchStats {
+    uint64_t decisions = 0;
+    uint64_t playouts = 0;
+    double seconds = 0.;
+    inline double playouts_per_sec() const {return seconds > 0. ? (double)playouts / seconds : 0.;}
+};
+
+/**
+ * determinized monte carlo tree search.
+ * every playout deals the cards this seat can't see at random from the unseen
+ * deck, then walks a UCT tree over the abstract bets (PokerAbstraction.h).
+ * at a discard decision the root branches on discard_candidates(), deeper
+ * discards and the rollouts use default_discard(). cards this seat threw away
+ * earlier in the hand are out of the unseen deck too.
+ */
 struct BasicAIPlayer : public PokerPlayerController {
-    BasicAIPlayer() : PokerPlayerController() {}
-    virtual PokerBetAction* bet(PokerState const& game, PokerPlayer const& player) override final;
-    virtual ControlResult discard(PokerState const& game, PokerPlayer const& player) override final;
+    BasicAIPlayer(MCTSConfig cfg = MCTSConfig());
+    virtual PokerBetAction* bet(PokerObservation const& obs, PokerPlayer const& player) override final;
+    virtual ControlResult discard(PokerObservation const& obs, PokerPlayer const& player) override final;
+
+    MCTSConfig config;
+    SearchStats last;           /* the most recent decision */
+    SearchStats total;          /* every decision so far */
+private:
+    std::mt19937_64 rng;
+    /* own discards this hand, with the round and history length they were made at */
+    uint8_t discarded[52];
+    size_t ndiscarded = 0;
+    uint8_t discard_round = 0;
+    uint8_t discard_history = 0;
+    size_t search(PokerObservation const& obs, uint8_t const* root_discards, size_t ndiscards);
+    void forget_discards(PokerObservation const& obs);
+};
+
+/* plays the MCTS rollout policy, cheap filler for simulations */
+struct RandomAIPlayer : public PokerPlayerController {
+    RandomAIPlayer(uint64_t seed = 0);
+    virtual PokerBetAction* bet(PokerObservation const& obs, PokerPlayer const& player) override final;
+    virtual ControlResult discard(PokerObservation const& obs, PokerPlayer const& player) override final;
+private:
+    std::mt19937_64 rng;
 };
 
+/* the rollout policy over a legal mask from abs_legal() */
+absBet_e rollout_bet(uint8_t legal, std::mt19937_64& rng);
+
 #endif /* POKER_AI_H */
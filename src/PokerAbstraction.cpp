@@ -0,0 +1,160 @@
+#include "PokerAbstraction.h"
+#include <cmath>
+
+const char* abs_name(absBet_e a) {
+    static const char* names[] = {
+        "FOLD",
+        "CALL",
+        "RAISE",
+        "ALLIN",
+    }; return names[a];
+}
+
+static Money abs_raise_to(Money bet, Money pot) {
+    Money inc = floorl(pot / 2);
+    return bet + (inc < 1. ? 1. : inc);
+}
+
+static uint8_t abs_legal(bool bet_check, Money bet, Money seat_bet, Money stack, Money pot) {
+    uint8_t legal = 1u << ABS_CALL;
+    if (!bet_check && bet > seat_bet) legal |= 1u << ABS_FOLD;
+    if (abs_raise_to(bet, pot) - seat_bet < stack) legal |= 1u << ABS_RAISE;
+    if (stack > 0.) legal |= 1u << ABS_ALLIN;
+    return legal;
+}
+
+uint8_t abs_legal(PokerSnapshot const& snap) {
+    PokerSnapshot::Seat const& s = snap.seats[snap.turn];
+    return abs_legal(snap.state == PokerFSM::BET_CHECK, snap.bet, s.bet, s.stack, snap.pot);
+}
+
+uint8_t abs_legal(PokerObservation const& obs) {
+    return abs_legal(obs.state == PokerFSM::BET_CHECK, obs.bet, obs.seat_bet[obs.seat], obs.stack[obs.seat], obs.pot);
+}
+
+PokerSnapshotAction abs_to_snapshot(PokerSnapshot const& snap, absBet_e a) {
+    switch (a) {
+    case ABS_FOLD:
+        return PokerSnapshotAction{ACTION_FOLD, 0, 0.};
+    case ABS_CALL: {
+        /* a call the stack can't cover is all in */
+        PokerSnapshot::Seat const& s = snap.seats[snap.turn];
+        Money owe = snap.bet - s.bet;
+        uint8_t kind = owe <= 0. ? ACTION_CHECK : owe < s.stack ? ACTION_CALL : ACTION_ALLIN;
+        return PokerSnapshotAction{kind, 0, 0.};
+    }
+    case ABS_RAISE:
+        return PokerSnapshotAction{ACTION_RAISE, 0, abs_raise_to(snap.bet, snap.pot)};
+    default:
+        return PokerSnapshotAction{ACTION_ALLIN, 0, 0.};
+    }
+}
+
+PokerBetAction* abs_to_action(PokerObservation const& obs, absBet_e a) {
+    switch (a) {
+    case ABS_FOLD:
+        return new_bet_action(ACTION_FOLD, obs.seat);
+    case ABS_CALL:
+        return new_legal_bet_action(obs, obs.seat, ACTION_CALL);
+    case ABS_RAISE:
+        return new_bet_action(ACTION_RAISE, obs.seat, abs_raise_to(obs.bet, obs.pot));
+    default:
+        return new_bet_action(ACTION_ALLIN, obs.seat);
+    }
+}
+
+/* index order of the hand sorted by rank, low to high */
+static void rank_order(uint8_t const* hand, size_t n, uint8_t* order) {
+    for (size_t i = 0; i < n; i++) order[i] = (uint8_t)i;
+    for (size_t i = 1; i < n; i++) {
+        for (size_t j = i; j > 0 && hand[order[j]] % 13 < hand[order[j-1]] % 13; j--) {
+            uint8_t t = order[j]; order[j] = order[j-1]; order[j-1] = t;
+        }
+    }
+}
+
+static uint8_t kicker_mask(uint8_t const* hand, size_t n) {
+    uint8_t counts[13] = {0};
+    for (size_t i = 0; i < n; i++) counts[hand[i] % 13]++;
+    uint8_t mask = 0;
+    for (size_t i = 0; i < n; i++) if (counts[hand[i] % 13] == 1) mask |= (uint8_t)(1u << i);
+    return mask;
+}
+
+static uint8_t flush_draw_mask(uint8_t const* hand, size_t n) {
+    uint8_t counts[4] = {0};
+    for (size_t i = 0; i < n; i++) counts[hand[i] / 13]++;
+    for (uint8_t s = 0; s < 4; s++) {
+        if (counts[s] != 4) continue;
+        for (size_t i = 0; i < n; i++) if (hand[i] / 13 != s) return (uint8_t)(1u << i);
+    }
+    return 0;
+}
+
+/* 4 distinct ranks spanning at most 5, drop the odd card out */
+static uint8_t straight_draw_mask(uint8_t const* hand, size_t n, uint8_t const* order) {
+    if (n != 5) return 0;
+    for (size_t skip = 0; skip < 5; skip++) {
+        int lo = 99, hi = -1; uint16_t seen = 0; bool dup = false;
+        for (size_t k = 0; k < 5; k++) {
+            if (k == skip) continue;
+            int r = hand[order[k]] % 13;
+            if (seen & (1u << r)) dup = true;
+            seen |= (uint16_t)(1u << r);
+            lo = r < lo ? r : lo; hi = r > hi ? r : hi;
+        }
+        if (!dup && hi - lo <= 4) return (uint8_t)(1u << order[skip]);
+    }
+    return 0;
+}
+
+uint8_t discard_options(uint8_t const* hand, size_t n, uint8_t* masks) {
+    if (n > 5) n = 5;   /* masks and order are 5 cards wide */
+    uint8_t order[5];
+    rank_order(hand, n, order);
+    uint8_t all = (uint8_t)((1u << n) - 1);
+    masks[DRAW_PAT] = 0;
+    masks[DRAW_KICKERS] = kicker_mask(hand, n);
+    masks[DRAW_FLUSH] = flush_draw_mask(hand, n);
+    masks[DRAW_STRAIGHT] = straight_draw_mask(hand, n, order);
+    masks[DRAW_TOP2] = (uint8_t)(n > 2 ? all & ~((1u << order[n-1]) | (1u << order[n-2])) : 0);
+    masks[DRAW_TOP1] = (uint8_t)(n > 1 ? all & ~(1u << order[n-1]) : 0);
+    uint8_t legal = 1u << DRAW_PAT;
+    for (size_t i = 1; i < DRAW_LAST; i++) {
+        if (!masks[i]) continue;
+        bool dup = false;
+        for (size_t j = 0; j < i; j++) dup |= (legal & (1u << j)) && masks[j] == masks[i];
+        if (!dup) legal |= (uint8_t)(1u << i);
+    }
+    return legal;
+}
+
+size_t discard_candidates(uint8_t const* hand, size_t n, uint8_t* masks) {
+    uint8_t opts[DRAW_LAST];
+    uint8_t legal = discard_options(hand, n, opts);
+    size_t count = 0;
+    for (size_t i = 0; i < DRAW_LAST; i++) {
+        if (legal & (1u << i)) masks[count++] = opts[i];
+    }
+    return count;
+}
+
+uint8_t default_discard(uint8_t const* hand, size_t n) {
+    if (n < 2) return 0;
+    Card cards[5];
+    for (size_t i = 0; i < n && i < 5; i++) cards[i] = card_from_index(hand[i]);
+    return default_discard(hand, n, find_best_hand(cards, n < 5 ? n : 5));
+}
+
+uint8_t default_discard(uint8_t const* hand, size_t n, hand_e made) {
+    if (n < 2) return 0;
+    if (n > 5) n = 5;
+    if (made >= HAND_STRAIGHT) return 0;
+    if (made >= HAND_PAIR) return kicker_mask(hand, n);
+    uint8_t order[5];
+    rank_order(hand, n, order);
+    uint8_t draw = flush_draw_mask(hand, n);
+    if (!draw) draw = straight_draw_mask(hand, n, order);
+    if (draw) return draw;
+    return (uint8_t)(((1u << n) - 1) & ~((1u << order[n-1]) | (1u << order[n-2])));
+}
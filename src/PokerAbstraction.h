@@ -0,0 +1,51 @@
+/**
+ * PokerAbstraction.h
+ * poker
+ */
+#ifndef POKER_ABSTRACTION_H
+#define POKER_ABSTRACTION_H
+#include "PokerSnapshot.h"
+
+/**
+ * small discrete action set for the search and training AIs.
+ * raises are sized off the pot so the set doesn't depend on a bet size choice.
+ */
+typedef enum {
+    ABS_FOLD = 0,
+    ABS_CALL,           /* check or call, whichever is legal, all in when the stack is short */
+    ABS_RAISE,          /* raise by half the pot, at least 1 */
+    ABS_ALLIN,
+    ABS_LAST,
+} absBet_e;
+
+const char* abs_name(absBet_e a);
+
+/* bit i set if absBet_e i is legal for the seat to act */
+uint8_t abs_legal(PokerSnapshot const& snap);
+uint8_t abs_legal(PokerObservation const& obs);
+
+PokerSnapshotAction abs_to_snapshot(PokerSnapshot const& snap, absBet_e a);
+PokerBetAction* abs_to_action(PokerObservation const& obs, absBet_e a);
+
+/* a few sensible draws for a hand of card_index()es */
+typedef enum {
+    DRAW_PAT = 0,       /* keep everything */
+    DRAW_KICKERS,       /* drop every unpaired card */
+    DRAW_FLUSH,         /* drop the odd suit out of a 4 flush */
+    DRAW_STRAIGHT,      /* drop the odd card out of a 4 straight */
+    DRAW_TOP2,          /* keep the two highest */
+    DRAW_TOP1,          /* keep the highest */
+    DRAW_LAST,
+} absDraw_e;
+
+#define DISCARD_MAX_CANDIDATES DRAW_LAST
+/* fills masks[absDraw_e], returns bit i set if draw i applies and isn't a repeat of an earlier one */
+uint8_t discard_options(uint8_t const* hand, size_t n, uint8_t* masks);
+/* the distinct options packed to the front, returns the count */
+size_t discard_candidates(uint8_t const* hand, size_t n, uint8_t* masks);
+/* the one draw a plain player would make */
+uint8_t default_discard(uint8_t const* hand, size_t n);
+/* same, for a caller that already knows the hand class (PokerPlayer::best_hand()) */
+uint8_t default_discard(uint8_t const* hand, size_t n, hand_e made);
+
+#endif /* POKER_ABSTRACTION_H */
@@ -0,0 +1,45 @@
+#include "PokerArena.h"
+#include <cstdlib>
+
+thread_local PokerArena* PokerArena::current = 0;
+
+PokerArena::PokerArena() : base(first), size(ARENA_INLINE), at(0), block(0), spent(0) {}
+
+PokerArena::~PokerArena() {
+    for (auto& b : extra) free(b.base);
+}
+
+void* PokerArena::alloc(size_t n, size_t align) {
+    for (;;) {
+        size_t start = (at + align - 1) & ~(align - 1);
+        if (start + n <= size) {
+            at = start + n;
+            return base + start;
+        }
+        /* on to the next kept block, or a new one big enough */
+        if (block == extra.size()) {
+            size_t want = n + align > ARENA_BLOCK ? n + align : ARENA_BLOCK;
+            char* mem = (char*)aligned_alloc(alignof(std::max_align_t), (want + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1));
+            if (!mem) return 0;
+            extra.push_back(Block{mem, want});
+        }
+        spent += at;
+        Block& b = extra[block++];
+        base = b.base; size = b.size; at = 0;
+    }
+}
+
+void PokerArena::reset() {
+    base = first; size = ARENA_INLINE; at = 0; block = 0; spent = 0;
+}
+
+bool PokerArena::owns(void const* p) const {
+    char const* c = (char const*)p;
+    if (c >= first && c < first + ARENA_INLINE) return true;
+    for (auto& b : extra) {
+        if (c >= b.base && c < b.base + b.size) return true;
+    }
+    return false;
+}
+
+size_t PokerArena::used() const {return spent + at;}
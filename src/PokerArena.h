@@ -0,0 +1,55 @@
+/**
+ * PokerArena.h
+ * poker
+ */
+#ifndef POKER_ARENA_H
+#define POKER_ARENA_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define ARENA_INLINE 2048
+#define ARENA_BLOCK 8192
+
+/**
+ * bump allocator for things that live one hand. alloc() is a pointer bump,
+ * nothing is freed on its own, reset() takes it all back at once in O(1).
+ * the first ARENA_INLINE bytes live inside the arena, so a hand that fits
+ * never touches the heap; bigger hands grow blocks that are kept for the next.
+ * while a PokerArena::Use is alive on a thread, PokerBetActions made on that
+ * thread come out of it.
+ */
+struct PokerArena {
+    PokerArena();
+    ~PokerArena();
+    PokerArena(PokerArena const&) = delete;
+    PokerArena& operator=(PokerArena const&) = delete;
+
+    /* 0 when a new block can't be had, the arena is left as it was */
+    void* alloc(size_t n, size_t align = alignof(std::max_align_t));
+    void reset();
+    bool owns(void const* p) const;
+
+    size_t used() const;
+    size_t blocks() const {return extra.size();}
+
+    /* the arena actions on this thread allocate from, 0 for the heap */
+    static thread_local PokerArena* current;
+    struct Use {
+        PokerArena* prev;
+        inline Use(PokerArena& a) : prev(current) {current = &a;}
+        inline ~Use() {current = prev;}
+    };
+
+private:
+    struct Block {char* base; size_t size;};
+    alignas(std::max_align_t) char first[ARENA_INLINE];
+    std::vector<Block> extra;
+    char* base;             /* the block being bumped through, first or one of extra */
+    size_t size;
+    size_t at;
+    size_t block;           /* extra[block - 1] is being used, 0 means first */
+    size_t spent;           /* bytes in blocks already passed this hand */
+};
+
+#endif /* POKER_ARENA_H */
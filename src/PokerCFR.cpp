@@ -0,0 +1,380 @@
+#include "PokerCFR.h"
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <cstring>
+#include <string>
+
+/**
+ *  card abstraction
+ */
+
+#define CANONICAL_HANDS (13 * 13 * 13 * 13 * 13 * 5)
+
+uint32_t canonical_hand_index(uint8_t const* hand, size_t n) {
+    uint8_t ranks[5]; uint8_t suits[4] = {0};
+    if (n > 5) n = 5;
+    for (size_t i = 0; i < n; i++) {
+        ranks[i] = hand[i] % 13;
+        suits[hand[i] / 13]++;
+        for (size_t j = i; j > 0 && ranks[j] < ranks[j-1]; j--) {
+            uint8_t t = ranks[j]; ranks[j] = ranks[j-1]; ranks[j-1] = t;
+        }
+    }
+    uint8_t maxsuit = 1;
+    for (size_t s = 0; s < 4; s++) if (suits[s] > maxsuit) maxsuit = suits[s];
+    uint32_t idx = 0;
+    for (size_t i = 0; i < n; i++) idx = idx * 13 + ranks[i];
+    return idx * 5 + (maxsuit - 1);
+}
+
+/* same classes as find_best_hand(), from sorted ranks and the biggest suit */
+static uint16_t bucket_of(uint8_t const* ranks, size_t n, uint8_t maxsuit) {
+    uint8_t counts[13] = {0};
+    for (size_t i = 0; i < n; i++) counts[ranks[i]]++;
+    size_t pairs = 0; bool trip = false, quad = false;
+    for (size_t r = 0; r < 13; r++) {
+        pairs += counts[r] == 2;
+        trip |= counts[r] == 3;
+        quad |= counts[r] == 4;
+    }
+    bool distinct = !pairs && !trip && !quad;
+    bool straight = n == 5 && distinct && ranks[4] - ranks[0] == 4;
+    bool flush = n == 5 && maxsuit == 5;
+    hand_e cls = HAND_HIGHCARD;
+    if (straight && flush) cls = ranks[4] == RANK_ACE ? HAND_ROYAL_FLUSH : HAND_STRAIGHT_FLUSH;
+    else if (quad) cls = HAND_4OFAKIND;
+    else if (trip && pairs) cls = HAND_FULLHOUSE;
+    else if (flush) cls = HAND_FLUSH;
+    else if (straight) cls = HAND_STRAIGHT;
+    else if (trip) cls = HAND_3OFAKIND;
+    else if (pairs == 2) cls = HAND_2PAIR;
+    else if (pairs == 1) cls = HAND_PAIR;
+
+    bool straight4 = false;
+    for (size_t skip = 0; n == 5 && !straight && skip < 5; skip++) {
+        int lo = 99, hi = -1; uint16_t seen = 0; bool dup = false;
+        for (size_t k = 0; k < 5; k++) {
+            if (k == skip) continue;
+            if (seen & (1u << ranks[k])) dup = true;
+            seen |= (uint16_t)(1u << ranks[k]);
+            lo = ranks[k] < lo ? ranks[k] : lo; hi = ranks[k] > hi ? ranks[k] : hi;
+        }
+        straight4 |= !dup && hi - lo <= 4;
+    }
+    uint16_t draw = (maxsuit == 4 ? 1 : 0) | (straight4 ? 2 : 0);
+    return (uint16_t)(((cls * 13) + (n ? ranks[n-1] : 0)) * 4 + draw);
+}
+
+static std::vector<uint16_t> bucket_table;
+static std::once_flag bucket_once;
+
+static void build_buckets() {
+    bucket_table.assign(CANONICAL_HANDS, 0);
+    uint8_t r[5];
+    for (r[0] = 0; r[0] < 13; r[0]++)
+    for (r[1] = r[0]; r[1] < 13; r[1]++)
+    for (r[2] = r[1]; r[2] < 13; r[2]++)
+    for (r[3] = r[2]; r[3] < 13; r[3]++)
+    for (r[4] = r[3]; r[4] < 13; r[4]++) {
+        if (r[0] == r[4]) continue; /* 5 of a kind */
+        uint32_t idx = 0;
+        for (size_t i = 0; i < 5; i++) idx = idx * 13 + r[i];
+        for (uint8_t maxsuit = 1; maxsuit <= 5; maxsuit++)
+            bucket_table[idx * 5 + (maxsuit - 1)] = bucket_of(r, 5, maxsuit);
+    }
+}
+
+uint16_t hand_bucket(uint8_t const* hand, size_t n) {
+    if (n != 5) {
+        /* only reachable off a short deck, not worth a table */
+        uint8_t ranks[5]; uint8_t suits[4] = {0}; uint8_t maxsuit = 1;
+        for (size_t i = 0; i < n && i < 5; i++) {
+            ranks[i] = hand[i] % 13;
+            for (size_t j = i; j > 0 && ranks[j] < ranks[j-1]; j--) {
+                uint8_t t = ranks[j]; ranks[j] = ranks[j-1]; ranks[j-1] = t;
+            }
+            if (++suits[hand[i] / 13] > maxsuit) maxsuit = suits[hand[i] / 13];
+        }
+        return bucket_of(ranks, n < 5 ? n : 5, maxsuit);
+    }
+    std::call_once(bucket_once, build_buckets);
+    return bucket_table[canonical_hand_index(hand, n)];
+}
+
+uint64_t cfr_key(uint16_t bucket, uint8_t seat, uint8_t state, uint8_t round, uint64_t path) {
+    uint64_t k = path ^ (((uint64_t)bucket << 24) | ((uint64_t)seat << 16) | ((uint64_t)state << 8) | round);
+    /* splitmix64 finalizer, the table indexes with the low bits */
+    k += 0x9e3779b97f4a7c15ull;
+    k = (k ^ (k >> 30)) * 0xbf58476d1ce4e5b9ull;
+    k = (k ^ (k >> 27)) * 0x94d049bb133111ebull;
+    k ^= k >> 31;
+    return k ? k : 1;
+}
+
+/**
+ *  CfrTable
+ */
+
+#define CFR_PROBES 32
+
+static inline void atomic_add(std::atomic<float>& a, float v) {
+    float cur = a.load(std::memory_order_relaxed);
+    while (!a.compare_exchange_weak(cur, cur + v, std::memory_order_relaxed)) {}
+}
+
+CfrTable::CfrTable(size_t log2_slots, CfrGameConfig g)
+    : game(g), iterations(0), slots(new CfrSlot[(size_t)1 << log2_slots]), mask(((size_t)1 << log2_slots) - 1) {}
+
+CfrSlot const* CfrTable::find(uint64_t key) const {
+    for (size_t i = 0; i < CFR_PROBES; i++) {
+        CfrSlot const& s = slots[(key + i) & mask];
+        uint64_t k = s.key.load(std::memory_order_acquire);
+        if (k == key) return &s;
+        if (!k) return 0;
+    }
+    return 0;
+}
+
+CfrSlot* CfrTable::find_or_insert(uint64_t key) {
+    for (size_t i = 0; i < CFR_PROBES; i++) {
+        CfrSlot& s = slots[(key + i) & mask];
+        uint64_t k = s.key.load(std::memory_order_acquire);
+        if (k == key) return &s;
+        if (!k) {
+            if (s.key.compare_exchange_strong(k, key, std::memory_order_acq_rel)) return &s;
+            if (k == key) return &s;
+        }
+    }
+    return 0;
+}
+
+size_t CfrTable::used() const {
+    size_t n = 0;
+    for (size_t i = 0; i <= mask; i++) n += slots[i].key.load(std::memory_order_relaxed) != 0;
+    return n;
+}
+
+void CfrTable::average(CfrSlot const* slot, uint8_t legal, float* out) const {
+    float sum = 0.f; size_t nlegal = 0;
+    for (size_t a = 0; a < CFR_ACTIONS; a++) {
+        out[a] = 0.f;
+        if (!(legal & (1u << a))) continue;
+        nlegal++;
+        if (slot) sum += (out[a] = slot->strategy[a].load(std::memory_order_relaxed));
+    }
+    for (size_t a = 0; a < CFR_ACTIONS; a++) {
+        if (!(legal & (1u << a))) continue;
+        out[a] = sum > 0.f ? out[a] / sum : 1.f / (float)nlegal;
+    }
+}
+
+struct CfrFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t log2_slots;
+    uint32_t seats;
+    uint32_t rounds;
+    uint32_t _pad;
+    double stack;
+    uint64_t iterations;
+    uint64_t records;
+};
+
+struct CfrFileRecord {
+    uint64_t key;
+    float regret[CFR_ACTIONS];
+    float strategy[CFR_ACTIONS];
+};
+
+bool CfrTable::save(const char* path) const {
+    std::string tmp = std::string(path) + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (!f) {PLOG_ERROR("ERROR: can't write checkpoint %s\n", tmp.c_str()); return false;}
+    CfrFileHeader h = {{'P','K','C','F'}, 1, 0, game.seats, game.rounds, 0, game.stack, iterations, used()};
+    while (((size_t)1 << h.log2_slots) <= mask) h.log2_slots++;
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1;
+    for (size_t i = 0; ok && i <= mask; i++) {
+        CfrSlot const& s = slots[i];
+        CfrFileRecord r;
+        r.key = s.key.load(std::memory_order_relaxed);
+        if (!r.key) continue;
+        for (size_t a = 0; a < CFR_ACTIONS; a++) {
+            r.regret[a] = s.regret[a].load(std::memory_order_relaxed);
+            r.strategy[a] = s.strategy[a].load(std::memory_order_relaxed);
+        }
+        ok = fwrite(&r, sizeof(r), 1, f) == 1;
+    }
+    ok = (fclose(f) == 0) && ok;
+    /* a crash mid write leaves the last good checkpoint alone */
+    if (!ok || rename(tmp.c_str(), path) != 0) {
+        PLOG_ERROR("ERROR: writing checkpoint %s failed\n", path);
+        remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+CfrTable* CfrTable::load(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {PLOG_ERROR("ERROR: can't open checkpoint %s\n", path); return 0;}
+    CfrFileHeader h;
+    if (fread(&h, sizeof(h), 1, f) != 1 || memcmp(h.magic, "PKCF", 4) || h.version != 1 || h.log2_slots > 40) {
+        PLOG_ERROR("ERROR: %s is not a v1 cfr checkpoint\n", path);
+        fclose(f); return 0;
+    }
+    CfrGameConfig g; g.seats = h.seats; g.rounds = h.rounds; g.stack = h.stack;
+    CfrTable* table = new CfrTable(h.log2_slots, g);
+    table->iterations = h.iterations;
+    CfrFileRecord r;
+    for (uint64_t i = 0; i < h.records; i++) {
+        if (fread(&r, sizeof(r), 1, f) != 1) {
+            PLOG_ERROR("ERROR: checkpoint %s is truncated\n", path);
+            delete table; fclose(f); return 0;
+        }
+        CfrSlot* s = table->find_or_insert(r.key);
+        if (!s) continue;
+        for (size_t a = 0; a < CFR_ACTIONS; a++) {
+            s->regret[a].store(r.regret[a], std::memory_order_relaxed);
+            s->strategy[a].store(r.strategy[a], std::memory_order_relaxed);
+        }
+    }
+    fclose(f);
+    return table;
+}
+
+/**
+ *  CfrTrainer
+ */
+
+static void regret_match(CfrSlot const* slot, uint8_t legal, float* sigma) {
+    float sum = 0.f; size_t nlegal = 0;
+    for (size_t a = 0; a < CFR_ACTIONS; a++) {
+        sigma[a] = 0.f;
+        if (!(legal & (1u << a))) continue;
+        nlegal++;
+        if (!slot) continue;
+        float r = slot->regret[a].load(std::memory_order_relaxed);
+        if (r > 0.f) sum += (sigma[a] = r);
+    }
+    for (size_t a = 0; a < CFR_ACTIONS; a++) {
+        if (!(legal & (1u << a))) continue;
+        sigma[a] = sum > 0.f ? sigma[a] / sum : 1.f / (float)nlegal;
+    }
+}
+
+static size_t sample_action(float const* p, uint8_t legal, std::mt19937_64& rng) {
+    float r = (float)(rng() >> 40) * (1.f / (float)(1ull << 24));
+    size_t last = 0;
+    for (size_t a = 0; a < CFR_ACTIONS; a++) {
+        if (!(legal & (1u << a))) continue;
+        last = a;
+        if (r < p[a]) return a;
+        r -= p[a];
+    }
+    return last;
+}
+
+static double cfr_traverse(CfrTable& table, PokerSnapshot const& s, uint8_t traverser, std::mt19937_64& rng) {
+    if (s.over()) return (double)(s.seats[traverser].stack - (Money)table.game.stack);
+
+    PokerSnapshot::Seat const& seat = s.seats[s.turn];
+    const bool drawing = s.state == PokerFSM::DISCARD;
+    uint8_t draws[DRAW_LAST];
+    uint8_t legal = drawing ? discard_options(seat.hand, seat.nhand, draws) : abs_legal(s);
+    CfrSlot* slot = table.find_or_insert(cfr_key(hand_bucket(seat.hand, seat.nhand), s.turn, (uint8_t)s.state, s.round, s.path));
+    float sigma[CFR_ACTIONS];
+    regret_match(slot, legal, sigma);
+
+    auto child = [&](size_t a) {
+        PokerSnapshot c = s;
+        c.apply(drawing ? PokerSnapshotAction{0, draws[a], 0.} : abs_to_snapshot(s, (absBet_e)a));
+        return c;
+    };
+
+    if (s.turn == traverser) {
+        double util[CFR_ACTIONS]; double node = 0.;
+        for (size_t a = 0; a < CFR_ACTIONS; a++) {
+            if (!(legal & (1u << a))) continue;
+            util[a] = cfr_traverse(table, child(a), traverser, rng);
+            node += sigma[a] * util[a];
+        }
+        if (slot) {
+            for (size_t a = 0; a < CFR_ACTIONS; a++) {
+                if (legal & (1u << a)) atomic_add(slot->regret[a], (float)(util[a] - node));
+            }
+        }
+        return node;
+    }
+    if (slot) {
+        for (size_t a = 0; a < CFR_ACTIONS; a++) {
+            if (legal & (1u << a)) atomic_add(slot->strategy[a], sigma[a]);
+        }
+    }
+    return cfr_traverse(table, child(sample_action(sigma, legal, rng)), traverser, rng);
+}
+
+static void cfr_worker(CfrTable* table, uint64_t iterations, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    uint8_t deck[52];
+    for (uint8_t c = 0; c < 52; c++) deck[c] = c;
+    for (uint64_t it = 0; it < iterations; it++) {
+        for (uint8_t p = 0; p < table->game.seats; p++) {
+            for (size_t i = 51; i > 0; i--) {
+                size_t j = rng() % (i + 1);
+                uint8_t t = deck[i]; deck[i] = deck[j]; deck[j] = t;
+            }
+            PokerSnapshot s = PokerSnapshot::new_hand(table->game.seats, (Money)table->game.stack, table->game.rounds, deck);
+            s.advance();
+            cfr_traverse(*table, s, p, rng);
+        }
+    }
+}
+
+CfrTrainer::CfrTrainer(CfrTable& t, size_t nthreads, uint64_t seed)
+    : table(t), threads(nthreads ? nthreads : 1), rng(seed ? seed : std::random_device()()) {}
+
+double CfrTrainer::train(uint64_t iterations) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < threads; t++)
+        workers.emplace_back(cfr_worker, &table, iterations / threads, rng());
+    cfr_worker(&table, iterations / threads + iterations % threads, rng());
+    for (auto& w : workers) w.join();
+    table.iterations += iterations;
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return secs > 0. ? (double)iterations / secs / (double)threads : 0.;
+}
+
+/**
+ *  CfrPlayer
+ */
+
+CfrPlayer::CfrPlayer(CfrTable const& t, uint64_t seed) : PokerPlayerController(), table(t), rng(seed ? seed : std::random_device()()) {}
+
+size_t CfrPlayer::sample(uint64_t key, uint8_t legal, size_t fallback) {
+    CfrSlot const* slot = table.find(key);
+    if (!slot) return fallback;
+    float p[CFR_ACTIONS];
+    table.average(slot, legal, p);
+    return sample_action(p, legal, rng);
+}
+
+PokerBetAction* CfrPlayer::bet(PokerObservation const& obs, PokerPlayer const& player) {
+    (void)player;
+    uint64_t key = cfr_key(hand_bucket(obs.hand, obs.nhand), obs.seat, obs.state, obs.round, obs.history_key());
+    return abs_to_action(obs, (absBet_e)sample(key, abs_legal(obs), ABS_CALL));
+}
+
+PokerPlayerController::ControlResult CfrPlayer::discard(PokerObservation const& obs, PokerPlayer const& player) {
+    uint8_t draws[DRAW_LAST];
+    uint8_t legal = discard_options(obs.hand, obs.nhand, draws);
+    uint64_t key = cfr_key(hand_bucket(obs.hand, obs.nhand), obs.seat, obs.state, obs.round, obs.history_key());
+    size_t pick = sample(key, legal, DRAW_LAST);
+    uint8_t mask = pick < DRAW_LAST ? draws[pick] : default_discard(obs.hand, obs.nhand);
+    for (size_t i = 0; i < obs.nhand; i++) {
+        if (mask & (1u << i)) player.hand.mark(i);
+    }
+    return CONTROL_OK;
+}
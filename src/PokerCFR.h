@@ -0,0 +1,87 @@
+/**
+ * PokerCFR.h
+ * poker
+ */
+#ifndef POKER_CFR_H
+#define POKER_CFR_H
+#include <atomic>
+#include <memory>
+#include <random>
+#include "PokerGame.h"
+#include "PokerAbstraction.h"
+
+/**
+ * external sampling monte carlo CFR over the abstract game in PokerAbstraction.h.
+ * information sets are (seat, state, round, betting sequence, hand bucket), hashed
+ * into one flat open addressed table that every trainer thread updates lock free.
+ */
+
+/* sorted ranks plus the size of the biggest suit. that's all the evaluator can
+   tell apart, so suit permutations of a hand share an index */
+uint32_t canonical_hand_index(uint8_t const* hand, size_t n);
+/* card abstraction: made hand class and high card, plus 4 flush / 4 straight flags */
+uint16_t hand_bucket(uint8_t const* hand, size_t n);
+
+#define CFR_ACTIONS 6   /* max of ABS_LAST and DRAW_LAST */
+
+struct alignas(64) CfrSlot {
+    std::atomic<uint64_t> key;              /* 0 is empty */
+    std::atomic<float> regret[CFR_ACTIONS];
+    std::atomic<float> strategy[CFR_ACTIONS];
+};
+
+struct CfrGameConfig {
+    uint32_t seats = 2;
+    uint32_t rounds = 2;
+    double stack = 20.;
+};
+
+struct CfrTable {
+    CfrTable(size_t log2_slots = 20, CfrGameConfig game = CfrGameConfig());
+
+    CfrGameConfig game;
+    uint64_t iterations;
+
+    CfrSlot const* find(uint64_t key) const;
+    CfrSlot* find_or_insert(uint64_t key);
+    size_t used() const;
+    size_t size() const {return mask + 1;}
+
+    /* normalized average strategy over the legal actions, uniform if never visited */
+    void average(CfrSlot const* slot, uint8_t legal, float* out) const;
+
+    bool save(const char* path) const;
+    /* 0 on failure */
+    static CfrTable* load(const char* path);
+
+private:
+    std::unique_ptr<CfrSlot[]> slots;
+    size_t mask;
+};
+
+uint64_t cfr_key(uint16_t bucket, uint8_t seat, uint8_t state, uint8_t round, uint64_t path);
+
+struct CfrTrainer {
+    CfrTrainer(CfrTable& table, size_t threads = 1, uint64_t seed = 0);
+    /* runs iterations split over the threads, one traversal per seat each.
+       returns iterations per second per thread */
+    double train(uint64_t iterations);
+    CfrTable& table;
+    size_t threads;
+private:
+    std::mt19937_64 rng;
+};
+
+/* plays the average strategy out of a trained table, falls back to check/call and
+   default_discard() on information sets the table never saw */
+struct CfrPlayer : public PokerPlayerController {
+    CfrPlayer(CfrTable const& table, uint64_t seed = 0);
+    virtual PokerBetAction* bet(PokerObservation const& obs, PokerPlayer const& player) override final;
+    virtual ControlResult discard(PokerObservation const& obs, PokerPlayer const& player) override final;
+private:
+    CfrTable const& table;
+    std::mt19937_64 rng;
+    size_t sample(uint64_t key, uint8_t legal, size_t fallback);
+};
+
+#endif /* POKER_CFR_H */
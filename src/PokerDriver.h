@@ -8,25 +8,28 @@
 #include "Driver.h"
 #include "Deck.h"
 #include "Rendering.h"
+#include "SimThread.h"
+#include "PokerAI.h"
 #include <flgl/logger.h>
 LOG_MODULE(poker);
 using namespace glm;
 
-struct CardInst {
-    Card card;
-    vec2 pos;
-};
-
 class PokerDriver : public Driver {
     virtual void user_create() override final;
+    virtual void user_frame(float dt, Keyboard const& kb, Mouse const& mouse) override final;
     virtual void user_update(float dt, Keyboard const& kb, Mouse const& mouse) override final;
     virtual void user_render() override final;
     virtual void user_destroy() override final;
 
     OrthoCamera camera;
-    Deck deck;
-    CardInst card;
 
+    /* the game runs on its own thread, seat 0 is played from here */
+    SimThread sim;
+    GuiPlayer* gui = 0;
+    TableRenderer table;
+    uint8_t mask = 0;
+    int asked = -1;
+    void gui_input(Keyboard const& kb);
 };
 
 void PokerDriver::user_create() {
@@ -35,31 +38,62 @@ void PokerDriver::user_create() {
     camera = OrthoCamera(vec3(0.,0.,-1.), vec3(0,0.,1.), vec3(0.,1.,0.), 1e-6, 1e6, 6);
     this->use_cam(camera);
     CardRenderer::init();
+    table.init();
+    table.layout.radius = 2.2f;
 
-    deck = Deck::new_shuffled();
-    card.card = deck.draw();
-    card.pos = vec2(0.f);
+    gui = new GuiPlayer(sim.inputs);
+    sim.players.add(gui, 20.);
+    for (size_t i = 0; i < 3; i++) sim.players.add(new BasicAIPlayer(), 20.);
+    sim.step_delay_us = 250000;
+    sim.start();
 }
 
-void PokerDriver::user_update(float dt, Keyboard const& kb, Mouse const& mouse) {
+/* c check/call, r raise 1, a all in, f fold. 1-5 pick cards, enter discards / shows them (none shows the best 5) */
+void PokerDriver::gui_input(Keyboard const& kb) {
+    int now = gui->waiting.load(std::memory_order_relaxed);
+    if (now != asked) {
+        asked = now; mask = 0;
+        if (now == DECISION_BET) LOG_INF("your bet: c check/call, r raise 1, a all in, f fold\n");
+        if (now == DECISION_DISCARD) LOG_INF("your discard: 1-5 pick cards, enter to discard them\n");
+        if (now == DECISION_SHOW) LOG_INF("your show: 1-5 pick cards, enter to show them (none shows your best 5)\n");
+    }
+    if (now < 0) return;
+    GuiInput in{(pokerDecision_e)now, ACTION_CHECK, 0, 0.};
+    bool send = false;
+    if (now == DECISION_BET) {
+        if (kb[GLFW_KEY_C].pressed) {send = true;}
+        if (kb[GLFW_KEY_R].pressed) {send = true; in.action = ACTION_RAISE; in.amount = 1.;}
+        if (kb[GLFW_KEY_A].pressed) {send = true; in.action = ACTION_ALLIN;}
+        if (kb[GLFW_KEY_F].pressed) {send = true; in.action = ACTION_FOLD;}
+    } else {
+        for (int i = 0; i < 5; i++) if (kb[GLFW_KEY_1 + i].pressed) mask ^= (uint8_t)(1u << i);
+        if (kb[GLFW_KEY_ENTER].pressed) {send = true; in.mask = mask;}
+    }
+    /* never blocks, a full queue just drops the click */
+    if (send && !sim.inputs.push(in)) LOG_ERR("input queue full\n");
+}
+
+void PokerDriver::user_frame(float dt, Keyboard const& kb, Mouse const& mouse) {
     if (kb[GLFW_KEY_ESCAPE].down) this->close();
+    gui_input(kb);
+    /* whatever the sim published last, it never waits on us and we never wait on it */
+    if (sim.update()) table.sync(sim.table());
+}
+
+void PokerDriver::user_update(float dt, Keyboard const& kb, Mouse const& mouse) {
     camera.update();
-    if (mouse.left.pressed) {
-        card.card = deck.draw();
-        LOG_INF("drew a %s of %s\n", rank_name(card.card.rank), suit_name(card.card.suit)); 
-    }
-    card.pos = world_mouse(mouse.pos);
 }
 
 void PokerDriver::user_render() {
     gl.clear();
 
     CardRenderer::sync_to_camera(camera);
-    // CardRenderer::draw_card_at(card.card, card.pos.x, card.pos.y);
-    DeckRenderer::draw(deck, card.pos.x, card.pos.y, 5);
+    table.draw();
 }
 
 void PokerDriver::user_destroy() {
+    sim.stop();
+    table.destroy();
     CardRenderer::destroy();
     gl.destroy();
 }
@@ -0,0 +1,174 @@
+#include "PokerDuplicate.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define DUPLICATE_MAX_SEATINGS 720
+#define DUPLICATE_BATCH 16
+
+size_t duplicate_seatings(size_t bots, bool all, uint8_t* out, size_t max) {
+    if (bots < 2 || bots > POKER_MAX_SEATS) return 0;
+    uint8_t order[POKER_MAX_SEATS];
+    for (size_t b = 0; b < bots; b++) order[b] = (uint8_t)b;
+    size_t n = 0;
+    if (!all) {
+        for (; n < bots && n < max; n++)
+            for (size_t s = 0; s < bots; s++) out[n * bots + s] = (uint8_t)((s + n) % bots);
+        return n;
+    }
+    do {
+        if (n == max) return 0;
+        memcpy(out + n * bots, order, bots);
+        n++;
+    } while (std::next_permutation(order, order + bots));
+    return n;
+}
+
+double DuplicateStats::variance_cut(size_t b) const {
+    double dup = bot[b].deal.var() * (double)seatings;
+    return dup > 0. ? bot[b].hand.var() / dup : 0.;
+}
+
+void DuplicateStats::merge(DuplicateStats const& o) {
+    if (!bots) bots = o.bots;
+    if (!seatings) seatings = o.seatings;
+    deals += o.deals;
+    hands += o.hands;
+    for (size_t b = 0; b < POKER_MAX_SEATS; b++) {
+        bot[b].hand_sums.merge(o.bot[b].hand_sums);
+        bot[b].deal_sums.merge(o.bot[b].deal_sums);
+        bot[b].wins += o.bot[b].wins;
+        bot[b].deal_points += o.bot[b].deal_points;
+    }
+    refresh();
+}
+
+void DuplicateStats::refresh() {
+    for (size_t b = 0; b < bots; b++) {
+        bot[b].hand = bot[b].hand_sums.stats(DUPLICATE_TICKS);
+        bot[b].deal = bot[b].deal_sums.stats((double)DUPLICATE_TICKS * (double)seatings);
+    }
+}
+
+void DuplicateStats::report(const char* const* names) const {
+    lg("duplicate: %zu bots, %lu deals x %zu seatings = %lu hands in %.2fs\n",
+       bots, (unsigned long)deals, seatings, (unsigned long)hands, seconds);
+    lg("  %-12s %10s %7s %10s %10s %8s %8s %8s %12s %12s\n",
+       "bot", "net/hand", "won", "sd hand", "sd deal", "z", "dup z", "cut", "hands (2sd)", "dup hands");
+    for (size_t b = 0; b < bots; b++) {
+        DuplicateBotStats const& s = bot[b];
+        double m = s.deal.mean, hv = s.hand.var(), dv = s.deal.var();
+        double z = s.hand.sem() > 0. ? m / s.hand.sem() : 0.;
+        double dz = s.deal.sem() > 0. ? m / s.deal.sem() : 0.;
+        /* hands until the mean is 2 standard errors out, either way of scoring */
+        double need = m != 0. ? 4. * hv / (m * m) : 0.;
+        double dneed = m != 0. ? 4. * dv * (double)seatings / (m * m) : 0.;
+        char fallback[24];
+        snprintf(fallback, sizeof(fallback), "bot %zu", b);
+        lg("  %-12s %+10.4f %6.1f%% %10.3f %10.3f %8.2f %8.2f %7.1fx %12.0f %12.0f\n",
+           names && names[b] ? names[b] : fallback, m, hands ? 100. * (double)s.wins / (double)hands : 0.,
+           sqrt(hv), sqrt(dv), z, dz, variance_cut(b), need, dneed);
+    }
+    if (verdict != VERDICT_CONTINUE) lg("stopped early, the first bot's score is %s\n", verdict_name(verdict));
+}
+
+struct DuplicateShared {
+    DuplicateConfig const* cfg;
+    duplicate_bot_f make;
+    void* user;
+    uint8_t const* seatings;
+    size_t nseatings;
+    std::atomic<uint64_t> next;
+    std::atomic<bool> stop;
+    /* every finished batch merges into total and runs the stop rule */
+    std::mutex lock;
+    DuplicateStats* total;
+    SequentialTest test;
+};
+
+static void duplicate_deal(DuplicateShared& sh, uint64_t d, DuplicateStats& st, int64_t* deal_net) {
+    DuplicateConfig const& cfg = *sh.cfg;
+    const size_t n = cfg.bots;
+    for (size_t b = 0; b < n; b++) deal_net[b] = 0;
+    for (size_t i = 0; i < sh.nseatings; i++) {
+        uint8_t const* seat_bot = sh.seatings + i * n;
+        PlayerList players;
+        for (size_t s = 0; s < n; s++) {
+            uint64_t seed = (cfg.seed + d) * POKER_MAX_SEATS + seat_bot[s] + 1;
+            players.add(sh.make(seat_bot[s], seed, sh.user), cfg.stack);
+        }
+        PokerGame game(players, cfg.rounds, cfg.seed + d);
+        game.run();
+        for (size_t s = 0; s < n; s++) {
+            int64_t net = llround((double)(players[s].stack - cfg.stack) * DUPLICATE_TICKS);
+            DuplicateBotStats& b = st.bot[seat_bot[s]];
+            b.hand_sums.add(net);
+            b.wins += net > 0;
+            deal_net[seat_bot[s]] += net;
+        }
+        st.hands++;
+    }
+    for (size_t b = 0; b < n; b++) {
+        st.bot[b].deal_sums.add(deal_net[b]);
+        st.bot[b].deal_points += deal_net[b] > 0 ? 1. : deal_net[b] == 0 ? 0.5 : 0.;
+    }
+    st.deals++;
+}
+
+static void duplicate_worker(DuplicateShared* sh) {
+    while (!sh->stop.load(std::memory_order_relaxed)) {
+        const uint64_t last = sh->cfg->first + sh->cfg->deals;
+        uint64_t first = sh->next.fetch_add(DUPLICATE_BATCH, std::memory_order_relaxed);
+        if (first >= last) return;
+        uint64_t end = std::min<uint64_t>(first + DUPLICATE_BATCH, last);
+        DuplicateStats batch;
+        int64_t nets[DUPLICATE_BATCH][POKER_MAX_SEATS];
+        for (uint64_t d = first; d < end; d++) duplicate_deal(*sh, d, batch, nets[d - first]);
+        std::lock_guard<std::mutex> guard(sh->lock);
+        if (sh->cfg->on_result)
+            for (uint64_t d = first; d < end; d++) sh->cfg->on_result(d, nets[d - first], sh->cfg->result_user);
+        sh->total->merge(batch);
+        if (sh->total->verdict != VERDICT_CONTINUE) continue;
+        sh->total->verdict = sh->test.check(sh->total->bot[0].deal);
+        if (sh->total->verdict != VERDICT_CONTINUE) sh->stop.store(true, std::memory_order_relaxed);
+    }
+}
+
+DuplicateStats run_duplicate(DuplicateConfig const& cfg, duplicate_bot_f make, void* user) {
+    DuplicateStats total;
+    std::vector<uint8_t> seatings(DUPLICATE_MAX_SEATINGS * POKER_MAX_SEATS);
+    size_t nseatings = duplicate_seatings(cfg.bots, cfg.all_seatings, seatings.data(), DUPLICATE_MAX_SEATINGS);
+    if (!nseatings) {
+        PLOG_ERROR("ERROR: duplicate needs 2 to %d bots, got %zu\n", POKER_MAX_SEATS, cfg.bots);
+        return total;
+    }
+    total.bots = cfg.bots;
+    total.seatings = nseatings;
+    auto start = std::chrono::steady_clock::now();
+
+    DuplicateShared shared;
+    shared.cfg = &cfg;
+    shared.make = make;
+    shared.user = user;
+    shared.seatings = seatings.data();
+    shared.nseatings = nseatings;
+    shared.next = cfg.first;
+    shared.stop = false;
+    shared.total = &total;
+    shared.test = cfg.stop;
+    if (!shared.test.max_samples) shared.test.max_samples = cfg.deals;
+
+    const size_t threads = cfg.threads ? cfg.threads : 1;
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < threads; t++) workers.emplace_back(duplicate_worker, &shared);
+    duplicate_worker(&shared);
+    for (auto& w : workers) w.join();
+
+    total.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return total;
+}
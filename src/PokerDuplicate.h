@@ -0,0 +1,80 @@
+/**
+ * PokerDuplicate.h
+ * poker
+ */
+#ifndef POKER_DUPLICATE_H
+#define POKER_DUPLICATE_H
+#include "PokerGame.h"
+#include "PokerStats.h"
+
+/**
+ * duplicate poker for comparing bots. every deal (the seeded deck a PokerGame
+ * shuffles) is played once per seating: each bot takes every seat in turn, or
+ * every ordering of the bots when all_seatings is set. a bot's duplicate score
+ * for a deal is its average net over the seatings, so the cards mostly cancel
+ * out and what's left is play. the report compares that against scoring the
+ * same hands one at a time.
+ * with a stop rule the run ends early once the first bot's duplicate score is
+ * significantly away from 0 (it's zero sum, so that's the first bot against the
+ * rest) or provably within the margin of it. deals is then the most it will play.
+ */
+
+/* hand nets are summed exactly in 1/6000ths of a chip, so whole chip pots split 2 to 6
+   ways and cent bets add up the same however the deals are split */
+#define DUPLICATE_TICKS 6000
+
+/* makes bot b's controller for one hand. seed is fixed per deal and bot, so each
+   bot sees the same randomness in every seating of a deal. called from worker threads */
+typedef PokerPlayerController* (*duplicate_bot_f)(size_t bot, uint64_t seed, void* user);
+
+/* one finished deal: every bot's net over its seatings, in DUPLICATE_TICKS. called under
+   the run's lock, in the order deals finish */
+typedef void (*duplicate_result_f)(uint64_t deal, int64_t const* net, void* user);
+
+struct DuplicateConfig {
+    size_t bots = 2;            /* one seat each */
+    size_t rounds = 2;
+    Money stack = 20.;
+    uint64_t deals = 1000;
+    uint64_t first = 0;         /* plays deals first .. first + deals - 1, a shard of a bigger sweep */
+    uint64_t seed = 1;          /* deal d plays Deck::new_seeded(seed + d) */
+    bool all_seatings = false;  /* bots! orderings instead of bots rotations */
+    size_t threads = 1;
+    SequentialTest stop;        /* on the first bot's deal scores, margin in chips per hand */
+    duplicate_result_f on_result = 0;
+    void* result_user = 0;
+};
+
+struct DuplicateBotStats {
+    MomentSums hand_sums;       /* net per hand, in DUPLICATE_TICKS */
+    MomentSums deal_sums;       /* net over a deal's seatings, in DUPLICATE_TICKS */
+    RunningStats hand;          /* net chips, one hand at a time. from hand_sums */
+    RunningStats deal;          /* duplicate score, the average net over a deal's seatings. from deal_sums */
+    uint64_t wins = 0;          /* hands it finished up on */
+    double deal_points = 0.;    /* deals its score was positive on, 0 counts half */
+};
+
+struct DuplicateStats {
+    size_t bots = 0;
+    size_t seatings = 0;        /* hands per deal */
+    uint64_t deals = 0;
+    uint64_t hands = 0;
+    double seconds = 0.;
+    DuplicateBotStats bot[POKER_MAX_SEATS];
+    stopVerdict_e verdict = VERDICT_CONTINUE;
+
+    /* how many times fewer hands duplicate scoring needs for the same standard error */
+    double variance_cut(size_t b) const;
+    void merge(DuplicateStats const& other);
+    /* hand and deal from the sums, merge() does it */
+    void refresh();
+    /* names may be 0 */
+    void report(const char* const* names = 0) const;
+};
+
+/* seat s of seating i gets bot out[i * bots + s]. returns the number of seatings, 0 if bots is out of range */
+size_t duplicate_seatings(size_t bots, bool all, uint8_t* out, size_t max);
+
+DuplicateStats run_duplicate(DuplicateConfig const& cfg, duplicate_bot_f make, void* user);
+
+#endif /* POKER_DUPLICATE_H */
@@ -1,8 +1,16 @@
 #include "PokerGame.h"
+#include "TextBuf.h"
+#include "HandHistory.h"
+#include "PokerInstrument.h"
+#include "Trace.h"
+#include "PokerProfile.h"
+#include <cstring>
+#include <cstddef>
+#include <atomic>
 
 Money PokerPlayer::charge(Money amt) {
     stack -= amt; 
-    assert(stack > 0. && "overcharged player"); 
+    POKER_DCHECK(stack >= 0. && "overcharged player"); 
     return amt;
 }
 
@@ -24,6 +32,15 @@ void PokerPlayer::award(Money payout) {
 
 void PokerPlayer::end_round() {
     bet = 0.f; in = true; hand = Deck::new_empty();
+    hand_changed();
+}
+
+uint32_t PokerPlayer::strength() const {
+    if (!strength_ok) {
+        strength_cache = hand.strength();
+        strength_ok = true;
+    }
+    return strength_cache;
 }
 
 const char* PokerFSM::get_name() const {
@@ -114,7 +131,7 @@ void PokerFSM::next_PLAYER_RESET_SHOW(pokerFSMinput_e input) {
 void PokerFSM::next_BET_CHECK(pokerFSMinput_e input) {
     bool check = test_FSMinput(input, INP_CHECK);
     bool bet = test_FSMinput(input, INP_BET);
-    assert(check ^ bet && "one of check or bet must have happened, not both or none");
+    POKER_DCHECK(check ^ bet && "one of check or bet must have happened, not both or none");
     if (check)
         state = ADV_CHECK;
     if (bet)
@@ -173,7 +190,8 @@ PlayerList::~PlayerList() {
     for (auto& p : *this) delete p.controller;
 }
 void PlayerList::add(PokerPlayerController* player, Money buyin) {
-    this->push_back(PokerPlayer{this->size(), player, buyin, 0., Deck::new_empty(), true});
+    assert(this->size() < POKER_MAX_SEATS && "table full");
+    this->push_back(PokerPlayer(this->size(), player, buyin));
 }
 void PlayerList::set_turn(size_t t) {turn = t;}
 size_t PlayerList::get_turn() const {return turn;}
@@ -191,63 +209,168 @@ size_t PlayerList::num_in(PokerPlayer** one) {
 }
 bool PlayerList::any_in() {return num_in() > 0;}
 PokerPlayer* PlayerList::one_in() {PokerPlayer* res; size_t ni = num_in(&res); return ni == 1 ? res : 0;}
-void PlayerList::reset() {turn = _first;}
+void PlayerList::reset() {turn = poker_lap_start(*this, this->size(), _first);}
 void PlayerList::bring_all_in() {for (auto& p : *this) p.in = true;}
-PokerPlayer& PlayerList::get(size_t idx) {assert(idx < this->size() && "oob player get"); return this->at(idx);}
-PokerPlayer const& PlayerList::get(size_t idx) const {assert(idx < this->size() && "oob player get"); return this->at(idx);}
+PokerPlayer& PlayerList::get(size_t idx) {POKER_DCHECK(idx < this->size() && "oob player get"); return this->at(idx);}
+PokerPlayer const& PlayerList::get(size_t idx) const {POKER_DCHECK(idx < this->size() && "oob player get"); return this->at(idx);}
 PokerPlayer& PlayerList::cur() {return this->at(turn);}
 PokerPlayer& PlayerList::first() {return this->at(_first);}
 PokerPlayer* PlayerList::next() {
-    do {
-        turn = (turn + 1) % this->size();
-    } while (!cur().in && turn != _first);
+    turn = poker_next_seat(*this, this->size(), turn, _first);
     return &cur();
 }
 PokerPlayer* PlayerList::next_under(const Money call) {
-    PokerPlayer* const _first = &cur();
-    PokerPlayer* n;
-    do {
-        n = next();
-        if (n->bet < call) return n;
-    } while (n != _first);
-    return 0;
+    return poker_next_under(*this, this->size(), turn, _first, call) ? &cur() : 0;
 }
 
 /**
  * PokerState
  */
 
-PokerState::PokerState(PlayerList& incoming, size_t rounds) 
-    : PokerFSM({PokerFSM::DEAL}), deck(Deck::new_shuffled()), bet(0.), pot(0.), round(rounds), players(incoming) {
+PokerState::PokerState(PlayerList& incoming, size_t rounds, uint64_t sd) 
+    : PokerFSM({PokerFSM::DEAL}), seed(sd), deck(sd ? Deck::new_seeded(sd) : Deck::new_shuffled()), bet(0.), pot(0.), round(rounds), players(incoming), nhistory(0) {
+    memset(version, 0, sizeof(version));
 }
 
-void CheckAction::perform(PokerState& game) {
-    assert(game.bet == game.players.get(self).bet && "can't check if your bet doesn't match, call raise or fold");
+PokerState::PokerState(PlayerList& incoming, size_t rounds, Deck const& stacked) 
+    : PokerFSM({PokerFSM::DEAL}), seed(0), deck(stacked), bet(0.), pot(0.), round(rounds), players(incoming), nhistory(0) {
+    memset(version, 0, sizeof(version));
 }
-void CallAction::perform(PokerState& game) {
-    assert(game.bet > 0. && "call with no bet open");
-    assert(game.bet > game.players.get(self).bet && "call w no bet increase, check instead");
-    Money cash = game.players.get(self).charge_to_bet(game.bet);
-    game.pot += cash;
+
+static std::atomic<uint32_t> version_clock{0};
+
+void PokerState::touch(size_t pile) {
+    if (pile >= POKER_PILES) return;
+    uint32_t v;
+    do v = version_clock.fetch_add(1, std::memory_order_relaxed) + 1; while (!v);
+    version[pile] = v;
 }
-void RaiseAction::perform(PokerState& game) {
-    assert(bet > game.bet && "raise invalid");
-    Money cash = game.players.get(self).charge_to_bet(bet);
-    game.pot += cash;
-    game.bet = bet;
+
+void PokerState::record(pokerAction_e kind, size_t seat) {
+    if (nhistory >= POKER_MAX_HISTORY) return;
+    history[nhistory++] = PokerActionRecord{(uint8_t)seat, (uint8_t)kind, (uint8_t)round, 0, (float)players.get(seat).bet};
+}
+
+PokerObservation PokerState::observe(size_t seat) const {
+    PokerObservation obs;
+    memset(&obs, 0, sizeof(obs));
+    obs.pot = (double)pot;
+    obs.bet = (double)bet;
+    obs.seat = (uint8_t)seat;
+    obs.nseats = (uint8_t)players.size();
+    obs.turn = (uint8_t)players.get_turn();
+    obs.first = (uint8_t)players.get_first();
+    obs.state = (uint8_t)state;
+    obs.round = (uint8_t)round;
+    for (size_t i = 0; i < players.size() && i < POKER_MAX_SEATS; i++) {
+        PokerPlayer const& p = players[i];
+        obs.stack[i] = (double)p.stack;
+        obs.seat_bet[i] = (double)p.bet;
+        obs.in[i] = p.in;
+    }
+    Deck const& hand = players.get(seat).hand;
+    for (auto c : hand) {
+        if (obs.nhand == 5) break;
+        obs.hand[obs.nhand++] = card_index(c);
+    }
+    obs.nhistory = (uint8_t)nhistory;
+    memcpy(obs.history, history, nhistory * sizeof(PokerActionRecord));
+    return obs;
+}
+
+uint64_t PokerObservation::history_key() const {
+    uint64_t h = 0;
+    for (size_t i = 0; i < nhistory; i++)
+        h = poker_history_mix(h, history[i].seat, history[i].kind, history[i].round);
+    return h;
+}
+
+/* word at a time FNV-1a style mix over the used prefix, unused history slots are skipped */
+uint64_t PokerObservation::hash() const {
+    const size_t len = offsetof(PokerObservation, history) + nhistory * sizeof(PokerActionRecord);
+    const uint8_t* bytes = (const uint8_t*)this;
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i + 8 <= len; i += 8) {
+        uint64_t w; memcpy(&w, bytes + i, 8);
+        h = (h ^ w) * 0x100000001b3ull;
+        h ^= h >> 29;
+    }
+    return h;
 }
-void FoldAction::perform(PokerState& game) {
-    assert(game.state != PokerState::BET_CHECK && "can't fold when you can check");
-    game.players.get(self).in = false;
+
+static void perform_bet(PokerState& game, size_t self, pokerAction_e kind, Money raise_to) {
+    poker_apply_bet(game.players.get(self), kind, raise_to, game.state == PokerState::BET_CHECK, game.bet, game.pot);
 }
-void AllInAction::perform(PokerState& game) {
-    Money cash = game.players.get(self).charge_all();
-    game.pot += cash;
-    game.bet = (game.players.get(self).bet > game.bet) ? game.players.get(self).bet : game.bet;
+void CheckAction::perform(PokerState& game) {perform_bet(game, self, kind, 0.);}
+void CallAction::perform(PokerState& game) {perform_bet(game, self, kind, 0.);}
+void RaiseAction::perform(PokerState& game) {perform_bet(game, self, kind, bet);}
+void FoldAction::perform(PokerState& game) {perform_bet(game, self, kind, 0.);}
+void AllInAction::perform(PokerState& game) {perform_bet(game, self, kind, 0.);}
+
+const char* action_name(pokerAction_e action) {
+    static const char* names[] = {
+        "CHECK",
+        "CALL",
+        "RAISE",
+        "FOLD",
+        "ALLIN",
+    }; return names[action];
 }
 
+void* PokerBetAction::operator new(size_t n) {
+    if (PokerArena::current) {
+        if (void* p = PokerArena::current->alloc(n)) return p;
+    }
+    return ::operator new(n);
+}
+
+void PokerBetAction::operator delete(void* p) {
+    /* arena memory goes back all at once when the arena resets */
+    if (PokerArena::current && PokerArena::current->owns(p)) return;
+    ::operator delete(p);
+}
+
+PokerBetAction* new_bet_action(pokerAction_e kind, size_t self, Money bet) {
+    switch (kind) {
+    case ACTION_CHECK:
+        return new CheckAction(self);
+    case ACTION_CALL:
+        return new CallAction(self);
+    case ACTION_RAISE:
+        return new RaiseAction(self, bet);
+    case ACTION_FOLD:
+        return new FoldAction(self);
+    case ACTION_ALLIN:
+        return new AllInAction(self);
+    default:
+        return 0;
+    }
+}
 
-PokerPlayerController::ControlResult PokerPlayerController::show(PokerState const& game, PokerPlayer const& player) {
+PokerBetAction* new_legal_bet_action(PokerObservation const& obs, size_t self, unsigned kind, Money bet) {
+    Money seat_bet = obs.seat_bet[obs.seat], stack = obs.stack[obs.seat];
+    Money owe = (Money)obs.bet - seat_bet;
+    switch (kind) {
+    case ACTION_FOLD:
+        if (obs.state != PokerFSM::BET_CHECK) return new FoldAction(self);
+        break;
+    case ACTION_RAISE:
+        if (bet - seat_bet >= stack) return new AllInAction(self);
+        if (bet > obs.bet) return new RaiseAction(self, bet);
+        break;
+    case ACTION_ALLIN:
+        return new AllInAction(self);
+    default:
+        break;
+    }
+    /* check, call, and whatever couldn't be done as asked */
+    if (owe <= 0.) return new CheckAction(self);
+    if (owe < stack) return new CallAction(self);
+    return new AllInAction(self);
+}
+
+PokerPlayerController::ControlResult PokerPlayerController::show(PokerObservation const& obs, PokerPlayer const& player) {
+    (void)obs;
     assert(player.hand.size() == 5 && "if a players hand is bigger than a poker hand, you must show() to select what cards to play");
     player.hand.mark_all();
     return CONTROL_OK;
@@ -260,24 +383,34 @@ PokerPlayerController::ControlResult PokerPlayerController::show(PokerState cons
 // } poker_event_e;
 
 void PokerGame::Result::print() const {
+    TextBuf out; print(out);
+}
+
+void PokerGame::Result::print(TextBuf& out) const {
     if (status == END) {
-        printf("GAME OVER: PLAYER %lu WINS %.2Lf WITH A %s!\n", winner->index, payout, hand_name(winner->hand.find_best_hand()));
+        out.fmt("GAME OVER: PLAYER %lu WINS %.2Lf WITH A %s! ", winner->index, payout, hand_name(winner->best_hand()));
+        winner->hand.print(out);
     } else {
-        printf("game in progress, status %s\n", status == OK ? "OK" : "busy (waiting on a player)");
+        out.fmt("game in progress, status %s\n", status == OK ? "OK" : "busy (waiting on a player)");
     }
 }
 
 void PokerGame::print() const {
-    printf("\n\n====STATE INFO====\n");
-    printf("state: %s; round: %lu; pot: $%.2Lf; bet: $%.2Lf\n", this->get_name(), this->round, this->pot, this->bet);
-    printf("player %lu's turn (%lu first)\n", players.get_turn(), players.get_first());
-    printf("they have %.2Lf bet now, %.2Lf in their stack, their hand:\n", players.cur().bet, players.cur().stack);
-    players.cur().hand.print();
-    printf("result: "); result.print();
-    printf("===END===\n\n");
+    TextBuf out; print(out);
+}
+
+void PokerGame::print(TextBuf& out) const {
+    out.put("\n\n====STATE INFO====\n");
+    out.fmt("state: %s; round: %lu; pot: $%.2Lf; bet: $%.2Lf\n", this->get_name(), this->round, this->pot, this->bet);
+    out.fmt("player %lu's turn (%lu first)\n", players.get_turn(), players.get_first());
+    out.fmt("they have %.2Lf bet now, %.2Lf in their stack, their hand: ", players.cur().bet, players.cur().stack);
+    players.cur().hand.print(out);
+    out.put("result: "); result.print(out);
+    out.put("===END===\n\n");
 }
 
 pokerFSMinput_e PokerGame::execute() {
+    POKER_INSTRUMENT_STATE(state);
     result.status = Result::OK;
     switch (state) {
     case DEAL:
@@ -320,35 +453,70 @@ pokerFSMinput_e PokerGame::ready(pokerFSMinput_e inp) {
     return inp | INP_CONTROL_READY;
 }
 
+PokerBetAction* PokerGame::ask_bet() {
+    PokerObservation obs = observe(players.get_turn());
+    POKER_INSTRUMENT_DECISION(players.cur().controller, DECISION_BET, asked_at);
+    TRACE_ZONE("bet", "controller");
+    PokerBetAction* action = players.cur().controller->bet(obs, players.cur());
+    POKER_INSTRUMENT_ANSWERED(action != 0);
+    return action;
+}
+PokerPlayerController::ControlResult PokerGame::ask_discard() {
+    PokerObservation obs = observe(players.get_turn());
+    POKER_INSTRUMENT_DECISION(players.cur().controller, DECISION_DISCARD, asked_at);
+    TRACE_ZONE("discard", "controller");
+    PokerPlayerController::ControlResult res = players.cur().controller->discard(obs, players.cur());
+    POKER_INSTRUMENT_ANSWERED(res != PokerPlayerController::CONTROL_BUSY);
+    return res;
+}
+PokerPlayerController::ControlResult PokerGame::ask_show() {
+    PokerObservation obs = observe(players.get_turn());
+    POKER_INSTRUMENT_DECISION(players.cur().controller, DECISION_SHOW, asked_at);
+    TRACE_ZONE("show", "controller");
+    PokerPlayerController::ControlResult res = players.cur().controller->show(obs, players.cur());
+    POKER_INSTRUMENT_ANSWERED(res != PokerPlayerController::CONTROL_BUSY);
+    return res;
+}
+
 pokerFSMinput_e PokerGame::exec_DEAL() {
+    POKER_PROFILE(PROF_DEAL);
     assert(deck.size() == 52 && "deck not full");
+    if (recorder) recorder->begin(*this, seed);
     for (PokerPlayer& p : players) {
         assert(p.hand.size() == 0 && "players need to be reset first");
         p.hand = deck.deal(5);
+        p.hand_changed();
+        touch(p.index);
+        if (recorder) recorder->deal(p.index, p.hand);
     }
+    touch(POKER_PILE_DECK);
     return INP_NONE;
 }
 pokerFSMinput_e PokerGame::exec_PLAYER_RESET() {
     players.reset(); return INP_NONE;
 }
 pokerFSMinput_e PokerGame::exec_BET_CHECK() {
-    PokerBetAction* b = players.cur().controller->bet(*this, players.cur());
-    if (!b) return busy();
-    Money bet_before = this->bet;
-    b->perform(*this);
-    if (this->bet > bet_before)
-        return ready(INP_BET);
-    else
-        return ready(INP_CHECK);
+    POKER_PROFILE(PROF_BET);
+    /* all in, or a folded first seat after the discards. nothing to decide, an all in
+       may be under the bet from an earlier round */
+    if (poker_skips_bet(players.cur())) return ready(INP_CHECK);
+    return exec_bet();
 }
 pokerFSMinput_e PokerGame::exec_BET_OPEN() {
-    PokerBetAction* b = players.cur().controller->bet(*this, players.cur());
+    POKER_PROFILE(PROF_BET);
+    if (poker_skips_bet(players.cur())) return ready(INP_NONE);
+    return exec_bet();
+}
+pokerFSMinput_e PokerGame::exec_bet() {
+    PokerArena::Use use(arena);
+    PokerBetAction* b = ask_bet();
     if (!b) return busy();
+    Money bet_before = this->bet;
     b->perform(*this);
-    if (players.one_in())
-        return ready(INP_ONE_LEFT);
-    else
-        return ready(INP_NONE);
+    record(b->kind, players.get_turn());
+    if (recorder) recorder->bet(*this, b->kind, players.get_turn());
+    delete b;
+    return ready(poker_bet_input(state == BET_CHECK, this->bet > bet_before, players.num_in()));
 }
 pokerFSMinput_e PokerGame::exec_ADV_CHECK() {
     players.next();
@@ -361,20 +529,38 @@ pokerFSMinput_e PokerGame::exec_ROUND_CHECK() {
     return --round ? INP_MORE_ROUNDS : INP_NONE;
 }
 pokerFSMinput_e PokerGame::exec_DISCARD() {
-    if (players.cur().controller->discard(*this, players.cur())
-        == PokerPlayerController::CONTROL_BUSY) 
-            return busy();
+    POKER_PROFILE(PROF_DISCARD);
+    if (ask_discard() == PokerPlayerController::CONTROL_BUSY)
+        return busy();
+    /* a seat can only swap what the deck has left, marks past that stay in hand */
+    size_t left = deck.size(), at = 0;
+    for (auto c : players.cur().hand) {
+        if (c.mark && !left) players.cur().hand.mark(at, false);
+        else if (c.mark) left--;
+        at++;
+    }
+    uint8_t mask = 0;
+    if (recorder) {
+        size_t i = 0;
+        for (auto c : players.cur().hand) mask |= (uint8_t)(c.mark << i++);
+    }
     Deck disc = players.cur().hand.get_marked();
     players.cur().hand -= disc;
     for (auto c : disc) { (void)c;
         players.cur().hand.add(deck.draw());
     }
+    players.cur().hand_changed();
+    touch(players.get_turn());
+    touch(POKER_PILE_DECK);
+    if (recorder) recorder->discard(*this, players.get_turn(), mask);
     return ready(INP_NONE);
 }
 pokerFSMinput_e PokerGame::exec_SHOW() {
-    if (players.cur().controller->show(*this, players.cur())
-        == PokerPlayerController::CONTROL_BUSY) 
-            return busy();
+    POKER_PROFILE(PROF_SHOWDOWN);
+    if (ask_show() == PokerPlayerController::CONTROL_BUSY)
+        return busy();
+    touch(players.get_turn());
+    if (recorder) recorder->show(*this, players.get_turn());
     return ready(INP_NONE);
 }
 pokerFSMinput_e PokerGame::exec_DISCARD_ADV() {
@@ -384,34 +570,79 @@ pokerFSMinput_e PokerGame::exec_SHOW_ADV() {
     return exec_ADV_CHECK();
 }
 
+size_t settle_pots(size_t n, Money const* contrib, bool const* in, uint32_t const* strength, Money* won) {
+    /* live seats best hand first, equal hands smallest contribution first */
+    uint8_t order[POKER_MAX_SEATS] = {0};
+    size_t nlive = 0;
+    for (size_t i = 0; i < n; i++) {
+        won[i] = 0.;
+        if (!in[i]) continue;
+        size_t at = nlive++;
+        for (; at > 0; at--) {
+            uint8_t o = order[at-1];
+            if (strength[o] > strength[i] || (strength[o] == strength[i] && contrib[o] <= contrib[i])) break;
+            order[at] = o;
+        }
+        order[at] = (uint8_t)i;
+    }
+    POKER_CHECK(nlive && "nobody left to pay");
+    /* everything up to level is paid out. each contribution in a group of equal hands
+       caps a layer, the members who reached the cap split it */
+    Money level = 0.;
+    for (size_t g = 0; g < nlive;) {
+        size_t end = g + 1;
+        while (end < nlive && strength[order[end]] == strength[order[g]]) end++;
+        for (size_t k = g; k < end; k++) {
+            Money cap = contrib[order[k]];
+            if (cap <= level) continue;
+            Money layer = 0.;
+            for (size_t i = 0; i < n; i++)
+                if (contrib[i] > level) layer += (contrib[i] < cap ? contrib[i] : cap) - level;
+            Money share = layer / (Money)(end - k);
+            for (size_t w = k; w < end; w++) won[order[w]] += share;
+            level = cap;
+        }
+        g = end;
+    }
+    /* anything folded seats put in above every live seat goes to the best hand */
+    for (size_t i = 0; i < n; i++)
+        if (contrib[i] > level) won[order[0]] += contrib[i] - level;
+    return order[0];
+}
+
 pokerFSMinput_e PokerGame::exec_END() {
-    size_t besti = 0; hand_e best = HAND_HIGHCARD; rank_e highcard = RANK_2;
-    for (auto& p : players) {
-        if (p.in) {
-            Deck hand = p.hand.get_marked();
-            hand_e cur = hand.find_best_hand();
-            if (cur > best) {
-                best = cur;
-                besti = p.index;
-                highcard = hand.get_highcard().rank;
-            }
-            if (cur == best) {
-                rank_e cur_hc = hand.get_highcard().rank;
-                if (cur_hc > highcard) {
-                    highcard = cur_hc;
-                    best = cur;
-                    besti = p.index;
-                }
-            }
+    Money contrib[POKER_MAX_SEATS], won[POKER_MAX_SEATS];
+    uint32_t strength[POKER_MAX_SEATS];
+    bool in[POKER_MAX_SEATS];
+    size_t besti;
+    {
+        POKER_PROFILE(PROF_EVALUATE);
+        for (auto& p : players) {
+            contrib[p.index] = p.bet;
+            in[p.index] = p.in;
+            strength[p.index] = 0;
+            if (!p.in) continue;
+            /* nothing is shown when everyone else folded, strength is 0 then.
+               a full show is the usual case and reuses the cached strength */
+            size_t shown = 0;
+            for (auto c : p.hand) shown += c.mark;
+            if (shown == p.hand.size()) strength[p.index] = p.strength();
+            else if (shown) strength[p.index] = p.hand.get_marked().strength();
         }
+        besti = settle_pots(players.size(), contrib, in, strength, won);
     }
+    for (auto& p : players) p.award(won[p.index]);
     result.winner = &players.get(besti);
-    result.payout = pot;
+    result.payout = won[besti];
     result.status = Result::END;
+    if (recorder) recorder->end(*this, besti, won);
+    arena.reset();
     return INP_NONE;
 }
 
 PokerGame::Result PokerGame::step() {
+    TRACE_POLL();
+    TRACE_ZONE(get_name(), "engine");
     next(execute());
     return result;
 }
@@ -439,13 +670,13 @@ PokerGame::Result PokerGame::run_noisy() {
     return result;
 }
 
-PokerBetAction* ConsolePlayer::bet(PokerState const& game, PokerPlayer const& player) {
-    std::cout << "Player " << player.index << ", time to bet. here is your hand:\n";
+PokerBetAction* ConsolePlayer::bet(PokerObservation const& obs, PokerPlayer const& player) {
+    std::cout << "Player " << player.index << ", time to bet. here is your hand: " << std::flush;
     player.hand.print();
-    if (game.bet == player.bet) {
+    if (obs.bet == obs.seat_bet[obs.seat]) {
         std::cout << "you can 'check' or 'bet <n>' to open / raise. ";
-    } else if (game.bet > player.bet) {
-        std::cout << "you can 'call' (you owe " << game.bet - player.bet << "), 'fold' or raise with 'bet <n>'. ";
+    } else if (obs.bet > obs.seat_bet[obs.seat]) {
+        std::cout << "you can 'call' (you owe " << obs.bet - obs.seat_bet[obs.seat] << "), 'fold' or raise with 'bet <n>'. ";
     }
     std::string inp; std::cin >> inp;
     if (inp == "check") {
@@ -460,14 +691,15 @@ PokerBetAction* ConsolePlayer::bet(PokerState const& game, PokerPlayer const& pl
     }
     return new FoldAction(player.index);
 }
-PokerPlayerController::ControlResult ConsolePlayer::discard(PokerState const& game, PokerPlayer const& player) {
+PokerPlayerController::ControlResult ConsolePlayer::discard(PokerObservation const& obs, PokerPlayer const& player) {
+    (void)obs;
     std::cout << "Player " << player.index << ", time to discard. ";
     size_t i;
     Deck display = player.hand;
     do {
-        std::cout << "here is your hand:\n";
+        std::cout << "here is your hand: " << std::flush;
         display.print();
-        std::cout << "enter an idx to discard (0 thru n-1 top to bot) or 42 to stop: ";
+        std::cout << "enter an idx to discard (0 thru n-1 left to right) or 42 to stop: ";
         std::cin >> i;
         if (i == 42) break;
         Card pull = display.remove(i);
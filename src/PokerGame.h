@@ -6,15 +6,28 @@
 #ifndef POKER_GAME_H
 #define POKER_GAME_H
 #include <iostream>
+#include <type_traits>
 #include "util.h"
 #include "Deck.h"
+#include "PokerArena.h"
 
 
 typedef long double Money;
 
+#define POKER_MAX_SEATS 6
+#define POKER_MAX_HISTORY 48
+/* PokerState::version[] slots: one per seat's hand (by index), then the deck */
+#define POKER_PILE_DECK POKER_MAX_SEATS
+#define POKER_PILES (POKER_MAX_SEATS + 1)
+
 struct PokerPlayerController;
+struct HandHistoryWriter;
+
+struct PokerGame;
 
 struct PokerPlayer {
+    PokerPlayer(size_t idx, PokerPlayerController* ctrl, Money buyin)
+        : index(idx), controller(ctrl), stack(buyin), bet(0.), hand(Deck::new_empty()), in(true) {}
     size_t index;
     PokerPlayerController* controller;
     Money stack;
@@ -26,6 +39,15 @@ struct PokerPlayer {
     Money charge_all();
     void award(Money payout);
     void end_round();
+    /* hand_strength() of the whole hand, worked out the first time it's asked for after
+       the hand changes. the game marks it stale on deal, discard and end_round */
+    uint32_t strength() const;
+    hand_e best_hand() const {return strength_hand(strength());}
+private:
+    friend struct PokerGame;
+    void hand_changed() {strength_ok = false;}
+    mutable uint32_t strength_cache = 0;
+    mutable bool strength_ok = false;
 };
 
 typedef enum {
@@ -107,50 +129,221 @@ private:
     size_t _first, turn;
 };
 
+typedef enum {
+    ACTION_CHECK = 0,
+    ACTION_CALL,
+    ACTION_RAISE,
+    ACTION_FOLD,
+    ACTION_ALLIN,
+    ACTION_LAST,
+} pokerAction_e;
+
+const char* action_name(pokerAction_e action);
+
+/* one betting decision, as everyone at the table saw it */
+struct PokerActionRecord {
+    uint8_t seat;
+    uint8_t kind;           /* pokerAction_e */
+    uint8_t round;
+    uint8_t _pad;
+    float bet;              /* the players bet after acting */
+};
+
+/* running key over the public betting sequence, amounts left out. equal sequences give equal keys */
+static inline uint64_t poker_history_mix(uint64_t h, uint8_t seat, uint8_t kind, uint8_t round) {
+    uint64_t v = (uint64_t)seat | ((uint64_t)kind << 8) | ((uint64_t)round << 16);
+    return h ^ (v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2));
+}
+
+/**
+ * what one seat is allowed to know, in a fixed trivially copyable layout.
+ * built zeroed by PokerState::observe(), so equal observations are equal bytes
+ */
+struct PokerObservation {
+    double pot;
+    double bet;
+    double stack[POKER_MAX_SEATS];
+    double seat_bet[POKER_MAX_SEATS];
+    uint8_t seat;
+    uint8_t nseats;
+    uint8_t turn;
+    uint8_t first;
+    uint8_t state;          /* PokerFSM state */
+    uint8_t round;
+    uint8_t nhand;
+    uint8_t nhistory;
+    uint8_t hand[5];        /* card_index() of own hand, in hand order */
+    uint8_t in[POKER_MAX_SEATS];
+    uint8_t _pad[5];
+    PokerActionRecord history[POKER_MAX_HISTORY];
+    uint64_t hash() const;
+    uint64_t history_key() const;
+};
+static_assert(std::is_trivially_copyable_v<PokerObservation>, "observations are shipped as raw bytes");
+static_assert(sizeof(PokerObservation) % 8 == 0, "hash() walks observations in words");
+
 struct PokerState : public PokerFSM {
-    PokerState(PlayerList& incoming, size_t rounds = 2);
+    /* seed 0 shuffles from the os, anything else deals Deck::new_seeded(seed) */
+    PokerState(PlayerList& incoming, size_t rounds = 2, uint64_t seed = 0);
+    PokerState(PlayerList& incoming, size_t rounds, Deck const& stacked);
+    uint64_t seed;
     Deck deck;
     Money bet;
     Money pot;
     size_t round;
     PlayerList& players;
+    PokerActionRecord history[POKER_MAX_HISTORY];
+    size_t nhistory;
+    /* changes whenever that piles cards do (deal, discard, show), so a renderer can skip
+       piles it already has. values come from one process wide counter, never repeat,
+       and start at 0 in a new game */
+    uint32_t version[POKER_PILES];
+    void touch(size_t pile);
+    void record(pokerAction_e kind, size_t seat);
+    PokerObservation observe(size_t seat) const;
 };
 
+/**
+ * showdown settlement, shared by PokerGame and PokerSnapshot. per seat: contrib is
+ * what it put in this hand (its bet, which runs the whole hand), in whether it's
+ * still live, strength its shown hand_strength(). live seats are ranked once, then
+ * each group of equal hands, best first, takes the layers of the pot its members
+ * covered: the main pot, then the side pots above each short all in. ties split a
+ * layer evenly. won gets every seat's take, returns the seat with the best hand
+ */
+size_t settle_pots(size_t n, Money const* contrib, bool const* in, uint32_t const* strength, Money* won);
+
+/**
+ * the table rules, shared by PokerGame and PokerSnapshot so there's one copy of them.
+ * seats is anything indexable whose elements have in, bet and stack (PlayerList,
+ * PokerSnapshot::seats), n is how many there are.
+ */
+
+/* folded and all in seats aren't asked to bet */
+template <typename Seat>
+inline bool poker_skips_bet(Seat const& s) {return !s.in || s.stack <= 0.;}
+
+/* the next seat still in after turn, or first once the lap comes back around to it */
+template <typename Seats>
+inline size_t poker_next_seat(Seats const& seats, size_t n, size_t turn, size_t first) {
+    do {
+        turn = (turn + 1) % n;
+    } while (!seats[turn].in && turn != first);
+    return turn;
+}
+
+/* where a lap starts. a folded first seat isn't asked, the lap still ends when it comes back to it */
+template <typename Seats>
+inline size_t poker_lap_start(Seats const& seats, size_t n, size_t first) {
+    return seats[first].in ? first : poker_next_seat(seats, n, first, first);
+}
+
+/* moves turn to the next seat that owes on call, false if there's none. one lap at most,
+   the seat that just acted may have folded and won't come around again.
+   all in seats are short but have nothing left to call with */
+template <typename Seats>
+inline bool poker_next_under(Seats const& seats, size_t n, size_t& turn, size_t first, Money call) {
+    for (size_t i = 0; i < n; i++) {
+        turn = poker_next_seat(seats, n, turn, first);
+        if (seats[turn].in && seats[turn].bet < call && seats[turn].stack > 0.) return true;
+    }
+    return false;
+}
+
+/* one betting action by seat s against the table's bet and pot. raise_to is only read
+   for ACTION_RAISE, bet_check says whether the seat could have checked instead */
+template <typename Seat>
+inline void poker_apply_bet(Seat& s, pokerAction_e kind, Money raise_to, bool bet_check, Money& bet, Money& pot) {
+    Money cash = 0.;
+    switch (kind) {
+    case ACTION_CHECK:
+        POKER_DCHECK(bet == s.bet && "can't check if your bet doesn't match, call raise or fold");
+        break;
+    case ACTION_CALL:
+        POKER_DCHECK(bet > 0. && "call with no bet open");
+        POKER_DCHECK(bet > s.bet && "call w no bet increase, check instead");
+        cash = bet - s.bet;
+        s.bet = bet;
+        break;
+    case ACTION_RAISE:
+        POKER_DCHECK(raise_to > bet && "raise invalid");
+        cash = raise_to - s.bet;
+        s.bet = bet = raise_to;
+        break;
+    case ACTION_FOLD:
+        POKER_DCHECK(!bet_check && "can't fold when you can check");
+        s.in = false;
+        break;
+    case ACTION_ALLIN:
+        cash = s.stack;
+        s.bet += cash;
+        if (s.bet > bet) bet = s.bet;
+        break;
+    default:
+        break;
+    }
+    s.stack -= cash;
+    POKER_DCHECK(s.stack >= 0. && "overcharged player");
+    pot += cash;
+}
+
+/* what a bet state hands the FSM once its seat has acted */
+inline pokerFSMinput_e poker_bet_input(bool bet_check, bool raised, size_t num_in) {
+    if (bet_check) return raised ? INP_BET : INP_CHECK;
+    return num_in == 1 ? INP_ONE_LEFT : INP_NONE;
+}
+
+/**
+ * controllers hand these to the game, which performs and deletes them.
+ * made during a PokerGame's bet they come out of its arena (PokerArena.h),
+ * anywhere else from the heap.
+ */
 struct PokerBetAction {
-    inline PokerBetAction(size_t slf) : self(slf) {}
+    inline PokerBetAction(size_t slf, pokerAction_e k) : kind(k), self(slf) {}
+    virtual ~PokerBetAction() = default;
+    static void* operator new(size_t n);
+    static void operator delete(void* p);
     virtual void perform(PokerState& game) = 0;
+    pokerAction_e const kind;
 protected:
     size_t self;
 };
 struct CheckAction : public PokerBetAction {
-    CheckAction(size_t self) : PokerBetAction(self) {}
+    CheckAction(size_t self) : PokerBetAction(self, ACTION_CHECK) {}
     virtual void perform(PokerState& game) override final;
 };
 struct CallAction : public PokerBetAction {
-    CallAction(size_t self) : PokerBetAction(self) {}
+    CallAction(size_t self) : PokerBetAction(self, ACTION_CALL) {}
     virtual void perform(PokerState& game) override final;
 };
 struct RaiseAction : public PokerBetAction {
     Money bet;
-    RaiseAction(size_t self, Money b) : PokerBetAction(self), bet(b) {}
+    RaiseAction(size_t self, Money b) : PokerBetAction(self, ACTION_RAISE), bet(b) {}
     virtual void perform(PokerState& game) override final;
 };
 struct FoldAction : public PokerBetAction {
-    FoldAction(size_t self) : PokerBetAction(self) {}
+    FoldAction(size_t self) : PokerBetAction(self, ACTION_FOLD) {}
     virtual void perform(PokerState& game) override final;
 };
 struct AllInAction : public PokerBetAction {
-    AllInAction(size_t self) : PokerBetAction(self) {}
+    AllInAction(size_t self) : PokerBetAction(self, ACTION_ALLIN) {}
     virtual void perform(PokerState& game) override final;
 };
 
 
+/* builds the action for a kind, bet is only used by ACTION_RAISE. 0 for ACTION_LAST */
+PokerBetAction* new_bet_action(pokerAction_e kind, size_t self, Money bet = 0.);
+/* the same for a decision made outside the engine, made legal against obs first: out of
+   range kinds and folds in BET_CHECK check or call, calls and raises the stack can't
+   cover go all in, and a raise that doesn't raise checks or calls */
+PokerBetAction* new_legal_bet_action(PokerObservation const& obs, size_t self, unsigned kind, Money bet = 0.);
+
 struct PokerPlayerController {
     virtual ~PokerPlayerController() = default;
     typedef enum {CONTROL_BUSY = 0, CONTROL_OK} ControlResult;
-    virtual PokerBetAction* bet(PokerState const& game, PokerPlayer const& player) = 0;
-    virtual ControlResult discard(PokerState const& game, PokerPlayer const& player) = 0;
-    virtual ControlResult show(PokerState const& game, PokerPlayer const& player);
+    virtual PokerBetAction* bet(PokerObservation const& obs, PokerPlayer const& player) = 0;
+    virtual ControlResult discard(PokerObservation const& obs, PokerPlayer const& player) = 0;
+    virtual ControlResult show(PokerObservation const& obs, PokerPlayer const& player);
 };
 
 // typedef enum {
@@ -160,7 +353,8 @@ struct PokerPlayerController {
 // } poker_event_e;
 
 struct PokerGame : public PokerState {
-    PokerGame(PlayerList& incoming, size_t rounds = 2) : PokerState(incoming, rounds) {}
+    PokerGame(PlayerList& incoming, size_t rounds = 2, uint64_t seed = 0) : PokerState(incoming, rounds, seed) {}
+    PokerGame(PlayerList& incoming, size_t rounds, Deck const& stacked) : PokerState(incoming, rounds, stacked) {}
 
     struct Result {
         enum {
@@ -168,22 +362,38 @@ struct PokerGame : public PokerState {
             OK,
             END,
         } status;
-        PokerPlayer* winner;
-        Money payout;
+        PokerPlayer* winner;    /* best hand at END, the stacks are already paid */
+        Money payout;           /* winners take, less than the pot on splits and side pots */
         void print() const;
+        void print(TextBuf& out) const;
     } result{Result::OK, 0, 0.};
 
+    /* optional, every deal/action/discard/show/end is logged to it (HandHistory.h) */
+    HandHistoryWriter* recorder = 0;
+    /* this hands bet actions, reset at END */
+    PokerArena arena;
+
     void print() const;
+    void print(TextBuf& out) const;
 
     pokerFSMinput_e execute();
 
     pokerFSMinput_e busy();
     pokerFSMinput_e ready(pokerFSMinput_e inp = INP_NONE);
 
+    /* the controller calls, timed when built with POKER_INSTRUMENT from the first ask
+       to the answer, so a busy controller counts once. asked_at is 0 between decisions */
+    uint64_t asked_at = 0;
+    PokerBetAction* ask_bet();
+    PokerPlayerController::ControlResult ask_discard();
+    PokerPlayerController::ControlResult ask_show();
+
     pokerFSMinput_e exec_DEAL();
     pokerFSMinput_e exec_PLAYER_RESET();
     pokerFSMinput_e exec_BET_CHECK();
     pokerFSMinput_e exec_BET_OPEN();
+    /* asks the seat to act and performs it, for both bet states */
+    pokerFSMinput_e exec_bet();
     pokerFSMinput_e exec_ADV_CHECK();
     pokerFSMinput_e exec_ADV_OPEN();
     pokerFSMinput_e exec_ROUND_CHECK();
@@ -202,8 +412,8 @@ struct PokerGame : public PokerState {
 
 struct ConsolePlayer : public PokerPlayerController {
     ConsolePlayer() : PokerPlayerController() {}
-    virtual PokerBetAction* bet(PokerState const& game, PokerPlayer const& player) override final;
-    virtual ControlResult discard(PokerState const& game, PokerPlayer const& player) override final;
+    virtual PokerBetAction* bet(PokerObservation const& obs, PokerPlayer const& player) override final;
+    virtual ControlResult discard(PokerObservation const& obs, PokerPlayer const& player) override final;
 };
 
 
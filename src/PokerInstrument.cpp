@@ -0,0 +1,181 @@
+#include "PokerInstrument.h"
+#include "PokerGame.h"
+
+uint64_t LatencyHistogram::upper(size_t i) {
+    if (i < (1u << HIST_SUB_BITS)) return i;
+    size_t group = i >> HIST_SUB_BITS, sub = i & ((1u << HIST_SUB_BITS) - 1);
+    return ((((uint64_t)1 << HIST_SUB_BITS) + sub + 1) << (group - 1)) - 1;
+}
+
+uint64_t histogram_percentile(uint64_t const* counts, double q) {
+    uint64_t total = 0;
+    for (size_t i = 0; i < HIST_BUCKETS; i++) total += counts[i];
+    if (!total) return 0;
+    uint64_t want = (uint64_t)(q * (double)total);
+    if (want >= total) want = total - 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < HIST_BUCKETS; i++) {
+        seen += counts[i];
+        if (seen > want) return LatencyHistogram::upper(i);
+    }
+    return LatencyHistogram::upper(HIST_BUCKETS - 1);
+}
+
+#ifdef POKER_INSTRUMENT
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+#include <vector>
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+#define INSTRUMENT_MAX_STATES 16
+#define INSTRUMENT_MAX_CONTROLLERS 16
+
+struct ControllerHistograms {
+    std::type_info const* type;
+    LatencyHistogram decisions[DECISION_LAST];
+};
+
+/* one per thread, never freed so a report can still read threads that exited */
+struct ThreadInstruments {
+    LatencyHistogram states[INSTRUMENT_MAX_STATES];
+    std::atomic<ControllerHistograms*> controllers[INSTRUMENT_MAX_CONTROLLERS];
+    std::atomic<uint64_t> untyped;     /* decisions by controller types past the table */
+};
+
+static std::mutex registry_lock;
+static std::vector<ThreadInstruments*> registry;
+
+static ThreadInstruments& local() {
+    thread_local ThreadInstruments* mine = 0;
+    if (!mine) {
+        mine = new ThreadInstruments();
+        std::lock_guard<std::mutex> guard(registry_lock);
+        registry.push_back(mine);
+    }
+    return *mine;
+}
+
+void instrument_state(size_t state, uint64_t ns) {
+    if (state < INSTRUMENT_MAX_STATES) local().states[state].record(ns);
+}
+
+void instrument_decision(PokerPlayerController const* who, pokerDecision_e d, uint64_t ns) {
+    std::type_info const& type = typeid(*who);
+    ThreadInstruments& t = local();
+    for (size_t i = 0; i < INSTRUMENT_MAX_CONTROLLERS; i++) {
+        ControllerHistograms* c = t.controllers[i].load(std::memory_order_acquire);
+        if (!c) {
+            c = new ControllerHistograms();
+            c->type = &type;
+            t.controllers[i].store(c, std::memory_order_release);
+        }
+        if (*c->type == type) {
+            c->decisions[d].record(ns);
+            return;
+        }
+    }
+    t.untyped.store(t.untyped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+static std::string type_name(std::type_info const& type) {
+#ifdef __GNUG__
+    int status = 0;
+    char* nice = abi::__cxa_demangle(type.name(), 0, 0, &status);
+    if (nice && !status) {
+        std::string res(nice);
+        free(nice);
+        return res;
+    }
+#endif
+    return type.name();
+}
+
+static void add_counts(uint64_t* into, LatencyHistogram const& h) {
+    for (size_t i = 0; i < HIST_BUCKETS; i++) into[i] += h.counts[i].load(std::memory_order_relaxed);
+}
+
+static void report_row(const char* name, uint64_t const* counts) {
+    uint64_t n = 0, max = 0;
+    for (size_t i = 0; i < HIST_BUCKETS; i++) {
+        n += counts[i];
+        if (counts[i]) max = LatencyHistogram::upper(i);
+    }
+    if (!n) return;
+    lg("  %-28s %12lu %10.2f %10.2f %10.2f %12.2f\n", name, (unsigned long)n,
+       histogram_percentile(counts, 0.50) / 1000., histogram_percentile(counts, 0.99) / 1000.,
+       histogram_percentile(counts, 0.999) / 1000., max / 1000.);
+}
+
+void instrument_report() {
+    std::lock_guard<std::mutex> guard(registry_lock);
+    std::vector<uint64_t> counts(HIST_BUCKETS);
+    lg("engine latency over %zu threads, microseconds\n", registry.size());
+    lg("  %-28s %12s %10s %10s %10s %12s\n", "state", "count", "p50", "p99", "p999", "max");
+    for (size_t s = 0; s <= PokerFSM::END; s++) {
+        std::fill(counts.begin(), counts.end(), 0);
+        for (auto t : registry) add_counts(counts.data(), t->states[s]);
+        PokerFSM fsm; fsm.state = (decltype(fsm.state))s;
+        report_row(fsm.get_name(), counts.data());
+    }
+
+    /* the same controller type shows up once per thread, merge by type */
+    std::vector<std::type_info const*> types;
+    for (auto t : registry) {
+        for (size_t i = 0; i < INSTRUMENT_MAX_CONTROLLERS; i++) {
+            ControllerHistograms* c = t->controllers[i].load(std::memory_order_acquire);
+            if (!c) break;
+            bool seen = false;
+            for (auto ty : types) seen |= *ty == *c->type;
+            if (!seen) types.push_back(c->type);
+        }
+    }
+    static const char* decisions[DECISION_LAST] = {"bet", "discard", "show"};
+    lg("  %-28s %12s %10s %10s %10s %12s\n", "controller", "count", "p50", "p99", "p999", "max");
+    for (auto ty : types) {
+        std::string name = type_name(*ty);
+        for (size_t d = 0; d < DECISION_LAST; d++) {
+            std::fill(counts.begin(), counts.end(), 0);
+            for (auto t : registry) {
+                for (size_t i = 0; i < INSTRUMENT_MAX_CONTROLLERS; i++) {
+                    ControllerHistograms* c = t->controllers[i].load(std::memory_order_acquire);
+                    if (!c) break;
+                    if (*c->type == *ty) add_counts(counts.data(), c->decisions[d]);
+                }
+            }
+            report_row((name + "::" + decisions[d]).c_str(), counts.data());
+        }
+    }
+    uint64_t untyped = 0;
+    for (auto t : registry) untyped += t->untyped.load(std::memory_order_relaxed);
+    if (untyped)
+        lg("  %lu decisions weren't timed, a thread saw more than %d controller types\n",
+           (unsigned long)untyped, INSTRUMENT_MAX_CONTROLLERS);
+}
+
+void instrument_reset() {
+    /* racy against threads still recording, meant for between runs */
+    std::lock_guard<std::mutex> guard(registry_lock);
+    for (auto t : registry) {
+        for (auto& h : t->states)
+            for (auto& c : h.counts) c.store(0, std::memory_order_relaxed);
+        t->untyped.store(0, std::memory_order_relaxed);
+        for (size_t i = 0; i < INSTRUMENT_MAX_CONTROLLERS; i++) {
+            ControllerHistograms* c = t->controllers[i].load(std::memory_order_acquire);
+            if (!c) break;
+            for (auto& h : c->decisions)
+                for (auto& n : h.counts) n.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+#else
+
+void instrument_report() {lg("built without POKER_INSTRUMENT, nothing to report\n");}
+void instrument_reset() {}
+
+#endif /* POKER_INSTRUMENT */
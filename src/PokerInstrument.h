@@ -0,0 +1,98 @@
+/**
+ * PokerInstrument.h
+ * poker
+ */
+#ifndef POKER_INSTRUMENT_H
+#define POKER_INSTRUMENT_H
+#include <atomic>
+#include "util.h"
+
+/**
+ * opt in latency histograms for the engine, build with -DPOKER_INSTRUMENT.
+ * PokerGame times every execute() by FSM state and every bet/discard/show
+ * decision by controller type, from the first time it asks to the answer. each thread records into its own histograms with plain
+ * stores, instrument_report() merges them all at the end.
+ * without the flag the hooks are empty macros and report()/reset() do nothing.
+ */
+
+typedef enum {
+    DECISION_BET = 0,
+    DECISION_DISCARD,
+    DECISION_SHOW,
+    DECISION_LAST,
+} pokerDecision_e;
+
+/* log linear buckets, 32 per power of 2 (about 3% error), nanoseconds up to ~18 minutes */
+#define HIST_SUB_BITS 5
+#define HIST_MAX_BITS 40
+#define HIST_BUCKETS ((HIST_MAX_BITS - HIST_SUB_BITS + 1) << HIST_SUB_BITS)
+
+struct LatencyHistogram {
+    std::atomic<uint64_t> counts[HIST_BUCKETS];
+    /* one writing thread only, readers may look at any time */
+    inline void record(uint64_t ns) {
+        std::atomic<uint64_t>& c = counts[bucket(ns)];
+        c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    static inline size_t bucket(uint64_t v) {
+        if (v < (1u << HIST_SUB_BITS)) return (size_t)v;
+        size_t e = 63 - __builtin_clzll(v);
+        if (e >= HIST_MAX_BITS) return HIST_BUCKETS - 1;
+        return ((e - HIST_SUB_BITS + 1) << HIST_SUB_BITS) + ((v >> (e - HIST_SUB_BITS)) & ((1u << HIST_SUB_BITS) - 1));
+    }
+    /* largest value that lands in bucket i */
+    static uint64_t upper(size_t i);
+};
+
+/* q in [0, 1] over merged counts, 0 if empty */
+uint64_t histogram_percentile(uint64_t const* counts, double q);
+
+void instrument_report();
+void instrument_reset();
+
+#ifdef POKER_INSTRUMENT
+
+#include <chrono>
+
+struct PokerPlayerController;
+
+void instrument_state(size_t state, uint64_t ns);
+void instrument_decision(PokerPlayerController const* who, pokerDecision_e d, uint64_t ns);
+
+static inline uint64_t instrument_now() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct InstrumentStateScope {
+    size_t state; uint64_t start;
+    inline InstrumentStateScope(size_t s) : state(s), start(instrument_now()) {}
+    inline ~InstrumentStateScope() {instrument_state(state, instrument_now() - start);}
+};
+/* asked is when this decision was first asked for, kept by the caller across busy polls.
+   only a call marked answered records, and clears it for the next decision */
+struct InstrumentDecisionScope {
+    PokerPlayerController const* who; pokerDecision_e d; uint64_t& asked; bool answered;
+    inline InstrumentDecisionScope(PokerPlayerController const* w, pokerDecision_e k, uint64_t& a) : who(w), d(k), asked(a), answered(false) {
+        if (!asked) asked = instrument_now();
+    }
+    inline ~InstrumentDecisionScope() {
+        if (!answered) return;
+        instrument_decision(who, d, instrument_now() - asked);
+        asked = 0;
+    }
+};
+
+#define POKER_INSTRUMENT_STATE(state) InstrumentStateScope _instrument_state(state)
+#define POKER_INSTRUMENT_DECISION(who, d, asked) InstrumentDecisionScope _instrument_decision(who, d, asked)
+#define POKER_INSTRUMENT_ANSWERED(yes) (_instrument_decision.answered = (yes))
+
+#else
+
+#define POKER_INSTRUMENT_STATE(state) do {} while (0)
+#define POKER_INSTRUMENT_DECISION(who, d, asked) do {(void)(asked);} while (0)
+#define POKER_INSTRUMENT_ANSWERED(yes) do {} while (0)
+
+#endif /* POKER_INSTRUMENT */
+
+#endif /* POKER_INSTRUMENT_H */
@@ -0,0 +1,184 @@
+#include "PokerLeague.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+/* glicko's q, natural log odds per elo point */
+#define ELO_Q (log(10.) / 400.)
+/* glicko's c, rd a bot gains back per match it sits out: ~1200 matches from the floor to the max */
+#define LEAGUE_RD_C 10.
+
+static double now_seconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* discounts a result against an opponent we're unsure of */
+static double glicko_g(double rd) {
+    return 1. / sqrt(1. + 3. * ELO_Q * ELO_Q * rd * rd / (M_PI * M_PI));
+}
+
+static double glicko_expected(double ra, double rb, double rd_b) {
+    return 1. / (1. + pow(10., -glicko_g(rd_b) * (ra - rb) / 400.));
+}
+
+/* 1 / d^2, what n deals against b tell us about a */
+static double glicko_info(LeagueBot const& a, LeagueBot const& b, double n) {
+    double g = glicko_g(b.rd), e = glicko_expected(a.rating, b.rating, b.rd);
+    return ELO_Q * ELO_Q * g * g * e * (1. - e) * n;
+}
+
+/* a's rating variance after n more deals against b */
+static double glicko_var_after(LeagueBot const& a, LeagueBot const& b, double n) {
+    return 1. / (1. / (a.rd * a.rd) + glicko_info(a, b, n));
+}
+
+/* glicko's step before a rating period, what we knew fades with the periods since */
+static void glicko_age(LeagueBot& b, uint64_t period) {
+    double t = (double)(period - b.rated_at);
+    b.rd = std::min(sqrt(b.rd * b.rd + LEAGUE_RD_C * LEAGUE_RD_C * t), LEAGUE_RD_MAX);
+}
+
+size_t League::add(const char* name, duplicate_bot_f make, void* user, league_build_f build) {
+    LeagueBot b;
+    b.name = name;
+    b.make = make;
+    b.user = user;
+    b.build = build;
+    if (build) b.seen_build = build(bots.size(), user);
+    bots.push_back(b);
+    return bots.size() - 1;
+}
+
+void League::check_builds() {
+    for (size_t i = 0; i < bots.size(); i++) {
+        LeagueBot& b = bots[i];
+        if (!b.build) continue;
+        uint32_t now = b.build(i, b.user);
+        if (now == b.seen_build) continue;
+        b.seen_build = now;
+        b.rd = LEAGUE_RD_MAX;
+        lg("league: %s is build %u now, its rd is back to %.0f\n", b.name, now, b.rd);
+    }
+}
+
+bool League::next_match(size_t& a, size_t& b, uint64_t& seed) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (done.load(std::memory_order_relaxed)) return false;
+    if (config.max_matches && scheduled >= config.max_matches) return false;
+    check_builds();
+    /* the pairing whose two rating variances drop the most from one more match.
+       matches still running count as played, so workers spread out */
+    double best = -1.;
+    const double m = (double)config.match_deals;
+    for (size_t i = 0; i < bots.size(); i++) {
+        for (size_t j = i + 1; j < bots.size(); j++) {
+            double running = (double)pair(i, j).running * m;
+            LeagueBot bi = bots[i], bj = bots[j];
+            bi.rd = sqrt(glicko_var_after(bots[i], bots[j], running));
+            bj.rd = sqrt(glicko_var_after(bots[j], bots[i], running));
+            double gain = bi.rd * bi.rd - glicko_var_after(bi, bj, m)
+                        + bj.rd * bj.rd - glicko_var_after(bj, bi, m);
+            if (gain > best) {best = gain; a = i; b = j;}
+        }
+    }
+    pair(a, b).running++;
+    seed = config.seed + scheduled * config.match_deals;
+    scheduled++;
+    return true;
+}
+
+void League::finish(size_t a, size_t b, DuplicateStats const& st) {
+    std::lock_guard<std::mutex> guard(lock);
+    const double n = (double)st.deals;
+    const double points = st.bot[0].deal_points;
+    /* glicko, the match as n games in one rating period, both sides from the old values */
+    const uint64_t period = matches + 1;
+    glicko_age(bots[a], period);
+    glicko_age(bots[b], period);
+    LeagueBot const old_a = bots[a], old_b = bots[b];
+    double var_a = glicko_var_after(old_a, old_b, n), var_b = glicko_var_after(old_b, old_a, n);
+    bots[a].rating += ELO_Q * var_a * glicko_g(old_b.rd) * (points - n * glicko_expected(old_a.rating, old_b.rating, old_b.rd));
+    bots[b].rating += ELO_Q * var_b * glicko_g(old_a.rd) * ((n - points) - n * glicko_expected(old_b.rating, old_a.rating, old_a.rd));
+    bots[a].rd = std::max(sqrt(var_a), LEAGUE_RD_MIN);
+    bots[b].rd = std::max(sqrt(var_b), LEAGUE_RD_MIN);
+    bots[a].rated_at = bots[b].rated_at = period;
+    bots[a].deals += st.deals; bots[b].deals += st.deals;
+    bots[a].points += points; bots[b].points += n - points;
+    bots[a].chips += st.bot[0].deal.mean * n;
+    bots[b].chips -= st.bot[0].deal.mean * n;
+    pair(a, b).running--;
+    pair(a, b).deals += st.deals;
+    pair(b, a).deals += st.deals;
+    matches++;
+
+    double now = now_seconds();
+    if (config.max_matches && matches >= config.max_matches) done.store(true);
+    if (config.seconds > 0. && now - started >= config.seconds) done.store(true);
+    if (config.report_seconds > 0. && now - last_report >= config.report_seconds && !done.load()) {
+        last_report = now;
+        print_standings();
+    }
+}
+
+/* only adapts the bot index, duplicate bot 0 is a and 1 is b */
+struct LeagueMatch {
+    League const* league;
+    size_t a, b;
+};
+
+static PokerPlayerController* league_match_bot(size_t bot, uint64_t seed, void* user) {
+    LeagueMatch const& m = *(LeagueMatch const*)user;
+    size_t idx = bot ? m.b : m.a;
+    LeagueBot const& lb = m.league->bots[idx];
+    return lb.make(idx, seed, lb.user);
+}
+
+void League::worker(League* league) {
+    size_t a, b;
+    uint64_t seed;
+    while (league->next_match(a, b, seed)) {
+        DuplicateConfig cfg;
+        cfg.bots = 2;
+        cfg.rounds = league->config.rounds;
+        cfg.stack = league->config.stack;
+        cfg.deals = league->config.match_deals;
+        cfg.seed = seed;
+        LeagueMatch m{league, a, b};
+        league->finish(a, b, run_duplicate(cfg, league_match_bot, &m));
+    }
+}
+
+void League::run() {
+    if (bots.size() < 2) {PLOG_ERROR("ERROR: a league needs at least 2 bots\n"); return;}
+    if (!config.max_matches && config.seconds <= 0.) {PLOG_ERROR("ERROR: a league needs max_matches or seconds\n"); return;}
+    pairs.assign(bots.size() * bots.size(), Pair());
+    done = false;
+    scheduled = 0;
+    started = last_report = now_seconds();
+    const size_t threads = config.threads ? config.threads : 1;
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < threads; t++) workers.emplace_back(worker, this);
+    worker(this);
+    for (auto& w : workers) w.join();
+    standings();
+}
+
+void League::standings() {
+    std::lock_guard<std::mutex> guard(lock);
+    print_standings();
+}
+
+void League::print_standings() {
+    std::vector<size_t> order(bots.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t x, size_t y) {return bots[x].rating > bots[y].rating;});
+    lg("league: %lu matches in %.1fs\n", (unsigned long)matches, now_seconds() - started);
+    lg("  %-4s %-16s %8s %7s %10s %7s %10s\n", "", "bot", "rating", "+-2rd", "deals", "score", "chips/hand");
+    for (size_t r = 0; r < order.size(); r++) {
+        LeagueBot const& b = bots[order[r]];
+        double n = (double)b.deals;
+        lg("  %-4zu %-16s %8.1f %7.1f %10lu %6.1f%% %+10.4f\n", r + 1, b.name, b.rating, 2. * b.rd,
+           (unsigned long)b.deals, n > 0. ? 100. * b.points / n : 0., n > 0. ? b.chips / n : 0.);
+    }
+}
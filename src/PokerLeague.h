@@ -0,0 +1,91 @@
+/**
+ * PokerLeague.h
+ * poker
+ */
+#ifndef POKER_LEAGUE_H
+#define POKER_LEAGUE_H
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "PokerDuplicate.h"
+
+/**
+ * round robin league between registered bots, rated on the elo scale with glicko
+ * style uncertainty: every bot has a rating deviation that starts wide, narrows
+ * with deals played down to a floor, and widens again with the matches a bot sits
+ * out, or all the way when its build changes. a match moves a bot by how unsure
+ * we are of it.
+ * a match is a short heads up duplicate run (both seatings of match_deals
+ * deals), every deal counts as one game: a point for coming out ahead, half
+ * for even. worker threads pull matches from one scheduler, which picks the
+ * pairing with the most to gain: the biggest drop in the two bots' rating
+ * variance from one more match. that is largest for close pairings and bots
+ * with few deals behind them, so a new bot gets played first until it settles.
+ * ratings move as each match finishes, standings() can be called any time.
+ */
+
+#define LEAGUE_RD_MAX 350.     /* a bot we know nothing about */
+#define LEAGUE_RD_MIN 30.      /* never surer than this, bots can still change */
+
+/* which build of a bot plays now, a new value resets its rating deviation */
+typedef uint32_t (*league_build_f)(size_t bot, void* user);
+
+struct LeagueConfig {
+    size_t threads = 1;
+    uint64_t match_deals = 32;  /* per match, each played in both seatings */
+    uint64_t max_matches = 0;   /* 0 runs until seconds */
+    double seconds = 60.;       /* 0 runs until max_matches */
+    double report_seconds = 5.; /* standings while running, 0 for none */
+    size_t rounds = 2;
+    Money stack = 20.;
+    uint64_t seed = 1;
+};
+
+struct LeagueBot {
+    const char* name;
+    duplicate_bot_f make;       /* called with this bot's index in the league */
+    void* user;
+    league_build_f build;       /* 0 if the bot never changes */
+    double rating = 1500.;
+    double rd = LEAGUE_RD_MAX;  /* rating deviation, one sd */
+    uint64_t rated_at = 0;      /* the league's match count when this was last rated */
+    uint32_t seen_build = 0;
+    uint64_t deals = 0;
+    double points = 0.;
+    double chips = 0.;          /* summed duplicate score, chips per hand */
+};
+
+struct League {
+    LeagueConfig config;
+    std::vector<LeagueBot> bots;
+    uint64_t matches = 0;
+
+    League(LeagueConfig cfg = LeagueConfig()) : config(cfg) {}
+    /* before run() */
+    size_t add(const char* name, duplicate_bot_f make, void* user, league_build_f build = 0);
+    /* blocks until the budget is spent, then prints the final standings */
+    void run();
+    /* thread safe */
+    void standings();
+
+private:
+    struct Pair {
+        uint64_t deals = 0;
+        uint32_t running = 0;   /* matches in flight */
+    };
+    std::vector<Pair> pairs;
+    std::mutex lock;
+    std::atomic<bool> done{false};
+    uint64_t scheduled = 0;
+    double started = 0.;
+    double last_report = 0.;
+
+    Pair& pair(size_t a, size_t b) {return pairs[a * bots.size() + b];}
+    bool next_match(size_t& a, size_t& b, uint64_t& seed);
+    void check_builds();
+    void finish(size_t a, size_t b, DuplicateStats const& st);
+    void print_standings();
+    static void worker(League* league);
+};
+
+#endif /* POKER_LEAGUE_H */
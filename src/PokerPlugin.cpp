@@ -0,0 +1,203 @@
+#include "PokerPlugin.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <dlfcn.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/* keep() memory lives until the process exits, that's the point of it */
+static std::mutex keep_lock;
+static std::map<std::string, std::pair<void*, size_t>> kept;
+
+static void* host_keep(const char* key, size_t size, int* fresh) {
+    std::lock_guard<std::mutex> guard(keep_lock);
+    auto it = kept.find(key);
+    if (it != kept.end()) {
+        if (fresh) *fresh = 0;
+        return it->second.second == size ? it->second.first : 0;
+    }
+    void* mem = calloc(1, size ? size : 1);
+    if (!mem) return 0;
+    kept[key] = {mem, size};
+    if (fresh) *fresh = 1;
+    return mem;
+}
+
+static PokerPluginHost const host = {POKER_PLUGIN_ABI, 0, host_keep};
+
+static int64_t file_stamp(const char* path) {
+    struct stat st;
+    if (stat(path, &st)) return -1;
+#ifdef __linux__
+    return (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#else
+    return (int64_t)st.st_mtime;
+#endif
+}
+
+/* dlopen hands back the build it already has for a path (or inode) that's still open,
+   and a build overwritten in place under a live mapping crashes. copying first gives
+   every load its own file, which is unlinked again as soon as it's mapped */
+static void* open_copy(const char* path) {
+    FILE* in = fopen(path, "rb");
+    if (!in) {PLOG_ERROR("ERROR: can't read plugin %s\n", path); return 0;}
+    char tmp[] = "/tmp/poker_plugin_XXXXXX";
+    int fd = mkstemp(tmp);
+    if (fd < 0) {PLOG_ERROR("ERROR: can't make a temp file for plugin %s\n", path); fclose(in); return 0;}
+    char buf[1 << 16];
+    size_t n;
+    bool ok = true;
+    while (ok && (n = fread(buf, 1, sizeof(buf), in)) > 0)
+        ok = write(fd, buf, n) == (ssize_t)n;
+    ok = ok && !ferror(in);
+    fclose(in);
+    close(fd);
+    void* dl = ok ? dlopen(tmp, RTLD_NOW | RTLD_LOCAL) : 0;
+    if (!ok) PLOG_ERROR("ERROR: copying plugin %s failed\n", path);
+    else if (!dl) PLOG_ERROR("ERROR: dlopen(%s): %s\n", path, dlerror());
+    unlink(tmp);
+    return dl;
+}
+
+/**
+ *  PokerPlugin
+ */
+
+std::shared_ptr<PokerPlugin> PokerPlugin::open(const char* path, uint32_t generation) {
+    void* dl = open_copy(path);
+    if (!dl) return 0;
+    poker_plugin_entry_f entry = (poker_plugin_entry_f)dlsym(dl, POKER_PLUGIN_ENTRY);
+    PokerPluginAPI const* api = entry ? entry() : 0;
+    const char* err = 0;
+    if (!entry)                                       err = "no " POKER_PLUGIN_ENTRY " symbol";
+    else if (!api)                                    err = POKER_PLUGIN_ENTRY " returned 0";
+    else if (api->abi != POKER_PLUGIN_ABI)            err = "built for another plugin abi";
+    else if (api->obs_size != sizeof(PokerObservation)) err = "built against another PokerObservation";
+    else if (!api->create || !api->destroy || !api->bet || !api->discard) err = "missing functions";
+    else if (api->init && api->init(&host))           err = "init failed";
+    if (err) {
+        PLOG_ERROR("ERROR: plugin %s: %s\n", path, err);
+        dlclose(dl);
+        return 0;
+    }
+    std::shared_ptr<PokerPlugin> p(new PokerPlugin());
+    p->path = path;
+    p->generation = generation;
+    p->api = api;
+    p->dl = dl;
+    return p;
+}
+
+PokerPlugin::~PokerPlugin() {
+    if (!dl) return;
+    if (api->shutdown) api->shutdown();
+    dlclose(dl);
+}
+
+/**
+ *  PluginPlayer
+ */
+
+PluginPlayer::PluginPlayer(std::shared_ptr<PokerPlugin> plg, uint64_t seed, const char* args) : plugin(plg) {
+    bot = plugin->api->create(seed, args);
+    if (!bot) PLOG_ERROR("ERROR: plugin %s couldn't create a bot, it checks and calls\n", plugin->api->name);
+}
+
+PluginPlayer::~PluginPlayer() {
+    if (bot) plugin->api->destroy(bot);
+}
+
+PokerBetAction* PluginPlayer::bet(PokerObservation const& obs, PokerPlayer const& player) {
+    if (!bot) return new_legal_bet_action(obs, player.index, ACTION_CALL);
+    PokerPluginDecision d = {};
+    if (!plugin->api->bet(bot, &obs, &d)) return 0;
+    return new_legal_bet_action(obs, player.index, d.action, (Money)d.amount);
+}
+
+PokerPlayerController::ControlResult PluginPlayer::discard(PokerObservation const& obs, PokerPlayer const& player) {
+    if (!bot) return CONTROL_OK;
+    PokerPluginDecision d = {};
+    if (!plugin->api->discard(bot, &obs, &d)) return CONTROL_BUSY;
+    for (size_t i = 0; i < player.hand.size() && i < 5; i++) {
+        if (d.discard & (1u << i)) player.hand.mark(i);
+    }
+    return CONTROL_OK;
+}
+
+/**
+ *  PluginRegistry
+ */
+
+PluginRegistry::Entry* PluginRegistry::find(const char* name) {
+    for (auto& e : entries) if (e.name == name) return &e;
+    return 0;
+}
+
+bool PluginRegistry::load(const char* name, const char* path) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (find(name)) {PLOG_ERROR("ERROR: plugin %s is already loaded\n", name); return false;}
+    int64_t stamp = file_stamp(path);
+    auto p = PokerPlugin::open(path);
+    if (!p) return false;
+    entries.push_back(Entry{name, path, stamp, p});
+    return true;
+}
+
+bool PluginRegistry::reload(const char* name) {
+    std::shared_ptr<PokerPlugin> old;   /* released after the lock */
+    std::lock_guard<std::mutex> guard(lock);
+    Entry* e = find(name);
+    if (!e) {PLOG_ERROR("ERROR: plugin %s isn't loaded\n", name); return false;}
+    int64_t stamp = file_stamp(e->path.c_str());
+    auto p = PokerPlugin::open(e->path.c_str(), e->plugin->generation + 1);
+    if (!p) {PLOG_ERROR("ERROR: keeping build %u of plugin %s\n", e->plugin->generation, name); return false;}
+    e->mtime = stamp;
+    old = e->plugin;
+    e->plugin = p;
+    lg("plugin %s: build %u (%s)\n", name, p->generation, p->api->name);
+    return true;
+}
+
+size_t PluginRegistry::reload_changed() {
+    std::vector<std::string> changed;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        for (auto const& e : entries)
+            if (file_stamp(e.path.c_str()) != e.mtime) changed.push_back(e.name);
+    }
+    size_t n = 0;
+    for (auto const& name : changed) n += reload(name.c_str());
+    return n;
+}
+
+void PluginRegistry::unload(const char* name) {
+    std::shared_ptr<PokerPlugin> old;   /* released after the lock */
+    std::lock_guard<std::mutex> guard(lock);
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (entries[i].name != name) continue;
+        old = entries[i].plugin;
+        entries.erase(entries.begin() + i);
+        return;
+    }
+    PLOG_ERROR("ERROR: plugin %s isn't loaded\n", name);
+}
+
+std::shared_ptr<PokerPlugin> PluginRegistry::get(const char* name) {
+    std::lock_guard<std::mutex> guard(lock);
+    Entry* e = find(name);
+    return e ? e->plugin : 0;
+}
+
+PluginPlayer* PluginRegistry::make(const char* name, uint64_t seed, const char* args) {
+    auto p = get(name);
+    return p ? new PluginPlayer(p, seed, args) : 0;
+}
+
+void PluginRegistry::list() {
+    std::lock_guard<std::mutex> guard(lock);
+    for (auto const& e : entries)
+        lg("  %-24s %-16s build %u, %ld users\n", e.name.c_str(), e.plugin->api->name,
+           e.plugin->generation, (long)e.plugin.use_count() - 1);
+}
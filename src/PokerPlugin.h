@@ -0,0 +1,125 @@
+/**
+ * PokerPlugin.h
+ * poker
+ */
+#ifndef POKER_PLUGIN_H
+#define POKER_PLUGIN_H
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "PokerGame.h"
+
+/**
+ * bots as shared objects, loaded with dlopen while the process runs.
+ * a plugin exports one C function, POKER_PLUGIN_ENTRY, returning a table of
+ * C function pointers. the table carries the abi version and the
+ * PokerObservation size it was built against, and loading refuses anything that
+ * doesn't match this build. decisions come back as plain data, same as ShmResponse.
+ * a plugin is built against these headers but doesn't link the engine.
+ */
+
+#define POKER_PLUGIN_ABI 1
+#define POKER_PLUGIN_ENTRY "poker_plugin_v1"
+
+extern "C" {
+
+/* what the host hands a plugin at init */
+struct PokerPluginHost {
+    uint32_t abi;           /* POKER_PLUGIN_ABI */
+    uint32_t _pad;
+    /* size bytes of zeroed memory under key, owned by the host and kept across unload
+       and reload, so a new build of a plugin picks up the tables, caches or mmaps the
+       old one left there. *fresh is 1 the first time. 0 if key exists with another size */
+    void* (*keep)(const char* key, size_t size, int* fresh);
+};
+
+struct PokerPluginDecision {
+    uint8_t action;         /* pokerAction_e, bet only */
+    uint8_t discard;        /* bit i marks obs->hand[i], discard only */
+    uint8_t _pad[6];
+    double amount;          /* new bet for ACTION_RAISE */
+};
+
+/* every call but init and shutdown can come from many threads at once, on different bots */
+struct PokerPluginAPI {
+    uint32_t abi;           /* POKER_PLUGIN_ABI */
+    uint32_t obs_size;      /* sizeof(PokerObservation) */
+    const char* name;
+    /* once per load before anything else, nonzero fails the load. may be 0 */
+    int (*init)(PokerPluginHost const* host);
+    /* once before dlclose, after every bot is destroyed. may be 0 */
+    void (*shutdown)(void);
+    /* one bot, for one hand or many. args may be 0 */
+    void* (*create)(uint64_t seed, const char* args);
+    void (*destroy)(void* bot);
+    /* fill out and return 1, or return 0 for busy and get asked again */
+    int (*bet)(void* bot, PokerObservation const* obs, PokerPluginDecision* out);
+    int (*discard)(void* bot, PokerObservation const* obs, PokerPluginDecision* out);
+};
+
+typedef PokerPluginAPI const* (*poker_plugin_entry_f)(void);
+
+}
+
+/* host side */
+
+/* one dlopen'd build of a plugin. the last reference to it, a registry entry or a
+   live PluginPlayer, shuts it down and closes it */
+struct PokerPlugin {
+    std::string path;
+    uint32_t generation;    /* loads of this registry name so far, 1 for the first */
+    PokerPluginAPI const* api;
+
+    /* 0 on any error */
+    static std::shared_ptr<PokerPlugin> open(const char* path, uint32_t generation = 1);
+    ~PokerPlugin();
+private:
+    void* dl = 0;
+    PokerPlugin() = default;
+};
+
+struct PluginPlayer : public PokerPlayerController {
+    PluginPlayer(std::shared_ptr<PokerPlugin> plugin, uint64_t seed, const char* args = 0);
+    virtual ~PluginPlayer();
+    virtual PokerBetAction* bet(PokerObservation const& obs, PokerPlayer const& player) override final;
+    virtual ControlResult discard(PokerObservation const& obs, PokerPlayer const& player) override final;
+    /* a bot the plugin failed to create checks or calls every bet */
+    inline bool ok() const {return bot != 0;}
+private:
+    std::shared_ptr<PokerPlugin> plugin;
+    void* bot;
+};
+
+/**
+ * plugins by name, thread safe. reload opens a fresh copy of the file next to the
+ * old build: players made before keep the build they started with until they're
+ * deleted, new ones get the new build, and a failed reload keeps the old one.
+ * nothing the host owns is touched, so tables, caches and keep() memory stay warm.
+ * each build is dlopen'd from a private copy of the file, so rebuilding a plugin in
+ * place is safe while it's loaded.
+ */
+struct PluginRegistry {
+    bool load(const char* name, const char* path);
+    bool reload(const char* name);
+    /* reloads every plugin whose file changed since it was loaded, returns how many did */
+    size_t reload_changed();
+    /* players already made keep the plugin open */
+    void unload(const char* name);
+    std::shared_ptr<PokerPlugin> get(const char* name);
+    /* 0 if name isn't loaded */
+    PluginPlayer* make(const char* name, uint64_t seed, const char* args = 0);
+    void list();
+private:
+    struct Entry {
+        std::string name;
+        std::string path;
+        int64_t mtime;
+        std::shared_ptr<PokerPlugin> plugin;
+    };
+    std::mutex lock;
+    std::vector<Entry> entries;
+    Entry* find(const char* name);
+};
+
+#endif /* POKER_PLUGIN_H */
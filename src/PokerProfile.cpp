@@ -0,0 +1,181 @@
+#include "PokerProfile.h"
+#include "AllocCount.h"
+#include "util.h"
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <vector>
+#ifdef __linux__
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+std::atomic<bool> profile_enabled{false};
+
+/* one per thread, never freed so a report still sees threads that exited */
+struct ThreadProfile {
+    int leader = -1;
+    int fds[PROF_COUNTERS];
+    /* where each counter lands in a group read, -1 if it didn't open */
+    int slot[PROF_COUNTERS];
+    int nopen = 0;
+    std::atomic<uint64_t> calls[PROF_LAST];
+    std::atomic<uint64_t> ns[PROF_LAST];
+    std::atomic<uint64_t> allocs[PROF_LAST];
+    std::atomic<uint64_t> counters[PROF_LAST][PROF_COUNTERS];
+};
+
+static std::mutex registry_lock;
+static std::vector<ThreadProfile*> registry;
+static int open_errno = 0;
+static const char* counter_names[PROF_COUNTERS] = {"cycles", "instr", "L1d miss", "LLC miss", "br miss"};
+static const char* region_names[PROF_LAST] = {"shuffle", "deal", "bet", "discard", "showdown", "evaluate"};
+
+#ifdef __linux__
+static int perf_open(uint32_t type, uint64_t config, int group) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = group < 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+static void open_counters(ThreadProfile& t) {
+    static const uint32_t types[PROF_COUNTERS] = {
+        PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+    };
+    static const uint64_t configs[PROF_COUNTERS] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES,
+    };
+    for (size_t c = 0; c < PROF_COUNTERS; c++) {
+        t.fds[c] = perf_open(types[c], configs[c], t.leader);
+        t.slot[c] = -1;
+        if (t.fds[c] < 0) {
+            if (!open_errno) open_errno = errno;
+            continue;
+        }
+        if (t.leader < 0) t.leader = t.fds[c];
+        t.slot[c] = t.nopen++;
+    }
+    if (t.leader >= 0) {
+        ioctl(t.leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(t.leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+}
+#else
+static void open_counters(ThreadProfile& t) {
+    for (size_t c = 0; c < PROF_COUNTERS; c++) {t.fds[c] = -1; t.slot[c] = -1;}
+}
+#endif
+
+static ThreadProfile& local() {
+    thread_local ThreadProfile* mine = 0;
+    if (!mine) {
+        mine = new ThreadProfile();
+        std::lock_guard<std::mutex> guard(registry_lock);
+        open_counters(*mine);
+        registry.push_back(mine);
+    }
+    return *mine;
+}
+
+void profile_sample(ProfileSample& out) {
+    ThreadProfile& t = local();
+    memset(out.counters, 0, sizeof(out.counters));
+#ifdef __linux__
+    if (t.leader >= 0) {
+        uint64_t buf[1 + PROF_COUNTERS];
+        if (read(t.leader, buf, sizeof(buf)) > 0) {
+            for (size_t c = 0; c < PROF_COUNTERS; c++)
+                if (t.slot[c] >= 0 && (uint64_t)t.slot[c] < buf[0]) out.counters[c] = buf[1 + t.slot[c]];
+        }
+    }
+#endif
+    out.allocs = alloc_counts().allocs;
+    out.ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static inline void bump(std::atomic<uint64_t>& a, uint64_t v) {
+    a.store(a.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+}
+
+void profile_add(profRegion_e region, ProfileSample const& start) {
+    ProfileSample end;
+    profile_sample(end);
+    ThreadProfile& t = local();
+    bump(t.calls[region], 1);
+    bump(t.ns[region], end.ns - start.ns);
+    bump(t.allocs[region], end.allocs - start.allocs);
+    for (size_t c = 0; c < PROF_COUNTERS; c++) bump(t.counters[region][c], end.counters[c] - start.counters[c]);
+}
+
+void profile_start() {
+    local();
+    profile_enabled.store(true);
+}
+
+void profile_stop() {
+    profile_enabled.store(false);
+}
+
+ProfileTotals profile_totals(profRegion_e region) {
+    ProfileTotals res;
+    memset(&res, 0, sizeof(res));
+    std::lock_guard<std::mutex> guard(registry_lock);
+    for (auto t : registry) {
+        res.calls += t->calls[region].load(std::memory_order_relaxed);
+        res.ns += t->ns[region].load(std::memory_order_relaxed);
+        res.allocs += t->allocs[region].load(std::memory_order_relaxed);
+        for (size_t c = 0; c < PROF_COUNTERS; c++) {
+            res.counters[c] += t->counters[region][c].load(std::memory_order_relaxed);
+            res.have[c] |= t->slot[c] >= 0;
+        }
+    }
+    return res;
+}
+
+void profile_report(uint64_t hands, FILE* out) {
+    ProfileTotals all[PROF_LAST];
+    bool any = false;
+    for (size_t r = 0; r < PROF_LAST; r++) all[r] = profile_totals((profRegion_e)r);
+    for (size_t c = 0; c < PROF_COUNTERS; c++) any |= all[0].have[c];
+    if (!any) {
+#ifdef __linux__
+        fprintf(out, "profile: no hardware counters (perf_event_open: %s), time and allocations only\n", open_errno ? strerror(open_errno) : "not tried");
+#else
+        fprintf(out, "profile: no hardware counters on this platform, time and allocations only\n");
+#endif
+    }
+    if (!alloc_counting()) fprintf(out, "profile: built without POKER_COUNT_ALLOCS, allocations read 0\n");
+
+    for (int per_hand = 0; per_hand < (hands ? 2 : 1); per_hand++) {
+        double div = per_hand ? (double)hands : 1.;
+        fprintf(out, "%s\n", per_hand ? "per hand:" : "totals:");
+        fprintf(out, "  %-9s %12s %12s %10s", "region", "calls", "ms", "allocs");
+        for (size_t c = 0; c < PROF_COUNTERS; c++) if (all[0].have[c]) fprintf(out, " %14s", counter_names[c]);
+        if (all[0].have[PROF_CYCLES] && all[0].have[PROF_INSTRUCTIONS]) fprintf(out, " %6s", "ipc");
+        fputc('\n', out);
+        for (size_t r = 0; r < PROF_LAST; r++) {
+            ProfileTotals const& t = all[r];
+            if (!t.calls) continue;
+            fprintf(out, "  %-9s %12.2f %12.4f %10.2f", region_names[r], t.calls / div, t.ns / 1e6 / div, t.allocs / div);
+            for (size_t c = 0; c < PROF_COUNTERS; c++) if (all[0].have[c]) fprintf(out, " %14.1f", t.counters[c] / div);
+            if (all[0].have[PROF_CYCLES] && all[0].have[PROF_INSTRUCTIONS])
+                fprintf(out, " %6.2f", t.counters[PROF_CYCLES] ? (double)t.counters[PROF_INSTRUCTIONS] / t.counters[PROF_CYCLES] : 0.);
+            fputc('\n', out);
+        }
+    }
+}
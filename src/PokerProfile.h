@@ -0,0 +1,80 @@
+/**
+ * PokerProfile.h
+ * poker
+ */
+#ifndef POKER_PROFILE_H
+#define POKER_PROFILE_H
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+
+/**
+ * built in profiling for the engine hot spots. after profile_start() every
+ * POKER_PROFILE(region) scope reads this threads hardware counters on the way
+ * in and out (perf_event_open: cycles, instructions, L1d and LLC misses, branch
+ * misses) and adds up the difference, plus wall time and global allocations
+ * (those need -DPOKER_COUNT_ALLOCS, AllocCount.h). where perf isn't allowed
+ * (perf_event_paranoid, containers, not linux) it falls back to time and
+ * allocations and the report says why. before profile_start() a scope is one
+ * relaxed load. regions nest, each counts everything inside it.
+ */
+
+typedef enum {
+    PROF_SHUFFLE = 0,
+    PROF_DEAL,
+    PROF_BET,
+    PROF_DISCARD,
+    PROF_SHOWDOWN,
+    PROF_EVALUATE,
+    PROF_LAST,
+} profRegion_e;
+
+typedef enum {
+    PROF_CYCLES = 0,
+    PROF_INSTRUCTIONS,
+    PROF_L1D_MISSES,
+    PROF_LLC_MISSES,
+    PROF_BRANCH_MISSES,
+    PROF_COUNTERS,
+} profCounter_e;
+
+struct ProfileTotals {
+    uint64_t calls;
+    uint64_t ns;
+    uint64_t allocs;
+    uint64_t counters[PROF_COUNTERS];
+    bool have[PROF_COUNTERS];       /* false if this machine couldn't count it */
+};
+
+void profile_start();
+void profile_stop();
+/* merged over every thread that profiled */
+ProfileTotals profile_totals(profRegion_e region);
+/* per region totals, and per hand averages when hands > 0 */
+void profile_report(uint64_t hands, FILE* out = stdout);
+
+extern std::atomic<bool> profile_enabled;
+
+struct ProfileSample {
+    uint64_t ns;
+    uint64_t allocs;
+    uint64_t counters[PROF_COUNTERS];
+};
+void profile_sample(ProfileSample& out);
+void profile_add(profRegion_e region, ProfileSample const& start);
+
+struct ProfileScope {
+    profRegion_e region;
+    bool on;
+    ProfileSample start;
+    inline ProfileScope(profRegion_e r) : region(r), on(profile_enabled.load(std::memory_order_relaxed)) {
+        if (on) profile_sample(start);
+    }
+    inline ~ProfileScope() {if (on) profile_add(region, start);}
+};
+
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+#define POKER_PROFILE(region) ProfileScope PROFILE_CONCAT(_profile_scope, __LINE__)(region)
+
+#endif /* POKER_PROFILE_H */
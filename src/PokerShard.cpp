@@ -0,0 +1,199 @@
+#include "PokerShard.h"
+#include <algorithm>
+#include <cstring>
+
+void shard_deals(uint64_t sweep, uint32_t shard, uint32_t shards, uint64_t* first, uint64_t* count) {
+    /* the first sweep % shards shards take one extra deal */
+    uint64_t base = sweep / shards, extra = sweep % shards;
+    *first = base * shard + std::min<uint64_t>(shard, extra);
+    *count = base + (shard < extra);
+}
+
+static size_t record_words(ShardFileHeader const& h) {
+    return 1 + h.bots;
+}
+
+/**
+ *  ShardWriter
+ */
+
+ShardWriter* ShardWriter::open(const char* path, DuplicateConfig const& cfg, uint64_t sweep_deals, const char* const* names) {
+    FILE* f = fopen(path, "wb");
+    if (!f) {PLOG_ERROR("ERROR: can't open %s for writing\n", path); return 0;}
+    ShardWriter* w = new ShardWriter();
+    w->f = f;
+    w->head = ShardFileHeader();
+    ShardFileHeader& h = w->head;
+    h.magic = SHARD_FILE_MAGIC;
+    h.version = SHARD_VERSION;
+    h.bots = (uint32_t)cfg.bots;
+    h.rounds = (uint32_t)cfg.rounds;
+    h.all_seatings = cfg.all_seatings;
+    h.ticks = DUPLICATE_TICKS;
+    h.stack = (double)cfg.stack;
+    h.seed = cfg.seed;
+    h.sweep_deals = sweep_deals;
+    for (size_t b = 0; names && b < cfg.bots; b++) strncpy(h.names[b], names[b], SHARD_NAME_LEN - 1);
+    w->range = DealRange{cfg.first, cfg.first};
+    /* placeholder, finish() writes the real one */
+    w->ok = fwrite(&h, sizeof(h), 1, f) == 1;
+    return w;
+}
+
+void ShardWriter::on_result(uint64_t deal, int64_t const* net, void* user) {
+    ShardWriter& w = *(ShardWriter*)user;
+    int64_t rec[1 + POKER_MAX_SEATS];
+    rec[0] = (int64_t)deal;
+    memcpy(rec + 1, net, w.head.bots * sizeof(int64_t));
+    w.ok &= fwrite(rec, sizeof(int64_t), record_words(w.head), w.f) == record_words(w.head);
+    w.head.nresults++;
+    w.range.end = std::max(w.range.end, deal + 1);
+}
+
+bool ShardWriter::finish(DuplicateStats const& st) {
+    ShardFileHeader& h = head;
+    /* deals are handed out in order, so without an early stop they're one block */
+    POKER_CHECK(range.end - range.first == st.deals && "shard results have gaps");
+    h.seatings = (uint32_t)st.seatings;
+    h.deals = st.deals;
+    h.hands = st.hands;
+    h.seconds = st.seconds;
+    h.nranges = st.deals ? 1 : 0;
+    for (size_t b = 0; b < h.bots; b++) {
+        h.bot[b].hand = st.bot[b].hand_sums;
+        h.bot[b].deal = st.bot[b].deal_sums;
+        h.bot[b].wins = st.bot[b].wins;
+        h.bot[b].half_points = (uint64_t)(st.bot[b].deal_points * 2.);
+    }
+    if (h.nranges) ok &= fwrite(&range, sizeof(range), 1, f) == 1;
+    ok &= fseek(f, 0, SEEK_SET) == 0 && fwrite(&h, sizeof(h), 1, f) == 1;
+    ok &= fflush(f) == 0;
+    if (!ok) PLOG_ERROR("ERROR: writing shard results failed\n");
+    return ok;
+}
+
+ShardWriter::~ShardWriter() {
+    if (f) fclose(f);
+}
+
+/**
+ *  ShardFile
+ */
+
+bool ShardFile::read(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {PLOG_ERROR("ERROR: can't open %s\n", path); return false;}
+    bool ok = fread(&head, sizeof(head), 1, f) == 1;
+    if (!ok || head.magic != SHARD_FILE_MAGIC || head.version != SHARD_VERSION
+            || head.bots < 2 || head.bots > POKER_MAX_SEATS) {
+        PLOG_ERROR("ERROR: %s isn't a v%d shard result file\n", path, SHARD_VERSION);
+        fclose(f);
+        return false;
+    }
+    ranges.resize(head.nranges);
+    long at = (long)(sizeof(head) + head.nresults * record_words(head) * sizeof(int64_t));
+    ok = fseek(f, at, SEEK_SET) == 0 && fread(ranges.data(), sizeof(DealRange), ranges.size(), f) == ranges.size();
+    fclose(f);
+    if (!ok) PLOG_ERROR("ERROR: %s is cut short\n", path);
+    return ok;
+}
+
+DuplicateStats ShardFile::stats() const {
+    DuplicateStats st;
+    st.bots = head.bots;
+    st.seatings = head.seatings;
+    st.deals = head.deals;
+    st.hands = head.hands;
+    st.seconds = head.seconds;
+    for (size_t b = 0; b < head.bots; b++) {
+        st.bot[b].hand_sums = head.bot[b].hand;
+        st.bot[b].deal_sums = head.bot[b].deal;
+        st.bot[b].wins = head.bot[b].wins;
+        st.bot[b].deal_points = (double)head.bot[b].half_points / 2.;
+    }
+    st.refresh();
+    return st;
+}
+
+/* everything but what's summed has to match */
+static bool same_sweep(ShardFileHeader const& a, ShardFileHeader const& b) {
+    return a.bots == b.bots && a.seatings == b.seatings && a.rounds == b.rounds
+        && a.all_seatings == b.all_seatings && a.ticks == b.ticks && a.stack == b.stack
+        && a.seed == b.seed && a.sweep_deals == b.sweep_deals && !memcmp(a.names, b.names, sizeof(a.names));
+}
+
+/* copies a file's deal records onto the end of out */
+static bool copy_records(const char* path, ShardFileHeader const& h, FILE* out) {
+    FILE* in = fopen(path, "rb");
+    if (!in) return false;
+    uint64_t left = h.nresults * record_words(h) * sizeof(int64_t);
+    bool ok = fseek(in, sizeof(h), SEEK_SET) == 0;
+    char buf[1 << 16];
+    while (ok && left) {
+        size_t n = (size_t)std::min<uint64_t>(left, sizeof(buf));
+        ok = fread(buf, 1, n, in) == n && fwrite(buf, 1, n, out) == n;
+        left -= n;
+    }
+    fclose(in);
+    return ok;
+}
+
+bool merge_shards(const char* const* paths, size_t n, ShardFile& out, const char* out_path) {
+    if (!n) return false;
+    for (size_t i = 0; out_path && i < n; i++)
+        if (!strcmp(out_path, paths[i])) {PLOG_ERROR("ERROR: merging into %s, one of the inputs\n", out_path); return false;}
+    std::vector<ShardFileHeader> heads(n);
+    out.ranges.clear();
+    for (size_t i = 0; i < n; i++) {
+        ShardFile f;
+        if (!f.read(paths[i])) return false;
+        if (i && !same_sweep(heads[0], f.head)) {
+            PLOG_ERROR("ERROR: %s is from another sweep than %s\n", paths[i], paths[0]);
+            return false;
+        }
+        heads[i] = f.head;
+        out.ranges.insert(out.ranges.end(), f.ranges.begin(), f.ranges.end());
+    }
+    /* sorted, overlaps refused, neighbours joined */
+    std::sort(out.ranges.begin(), out.ranges.end(), [](DealRange const& a, DealRange const& b) {return a.first < b.first;});
+    size_t kept = 0;
+    for (size_t r = 0; r < out.ranges.size(); r++) {
+        DealRange const& cur = out.ranges[r];
+        if (kept && cur.first < out.ranges[kept - 1].end) {
+            PLOG_ERROR("ERROR: deal %lu is in more than one of the files\n", (unsigned long)cur.first);
+            return false;
+        }
+        if (kept && cur.first == out.ranges[kept - 1].end) out.ranges[kept - 1].end = cur.end;
+        else out.ranges[kept++] = cur;
+    }
+    out.ranges.resize(kept);
+
+    ShardFileHeader& h = out.head;
+    h = heads[0];
+    h.deals = h.hands = h.nresults = 0;
+    h.seconds = 0.;
+    for (auto& b : h.bot) b = ShardBotSums();
+    for (auto const& f : heads) {
+        h.deals += f.deals;
+        h.hands += f.hands;
+        h.nresults += f.nresults;
+        h.seconds += f.seconds;
+        for (size_t b = 0; b < h.bots; b++) {
+            h.bot[b].hand.merge(f.bot[b].hand);
+            h.bot[b].deal.merge(f.bot[b].deal);
+            h.bot[b].wins += f.bot[b].wins;
+            h.bot[b].half_points += f.bot[b].half_points;
+        }
+    }
+    h.nranges = out.ranges.size();
+    if (!out_path) return true;
+
+    FILE* f = fopen(out_path, "wb");
+    if (!f) {PLOG_ERROR("ERROR: can't open %s for writing\n", out_path); return false;}
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1;
+    for (size_t i = 0; ok && i < n; i++) ok = copy_records(paths[i], heads[i], f);
+    ok = ok && fwrite(out.ranges.data(), sizeof(DealRange), out.ranges.size(), f) == out.ranges.size();
+    ok = fclose(f) == 0 && ok;
+    if (!ok) PLOG_ERROR("ERROR: writing %s failed\n", out_path);
+    return ok;
+}
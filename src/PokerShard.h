@@ -0,0 +1,96 @@
+/**
+ * PokerShard.h
+ * poker
+ */
+#ifndef POKER_SHARD_H
+#define POKER_SHARD_H
+#include <cstdio>
+#include <type_traits>
+#include <vector>
+#include "PokerDuplicate.h"
+
+/**
+ * duplicate sweeps split over processes or machines. shard i of n plays its own
+ * contiguous block of the sweep's deal numbers, so seeds never overlap and every
+ * shard deals exactly what one process would have. each shard writes a result
+ * file: a ShardFileHeader with the run's exact integer sums, then one record per
+ * deal (the deal number and every bot's net over its seatings in DUPLICATE_TICKS,
+ * in the order deals finished), then the DealRanges it covers. any subset of
+ * shards merges by adding the sums, so a complete merge reports the same bits as
+ * the sweep done in one go, and a merge is itself a result file that merges again.
+ * fixed layout, host endian like the hand histories.
+ */
+
+#define SHARD_FILE_MAGIC 0x44524853 /* SHRD */
+#define SHARD_VERSION 1
+#define SHARD_NAME_LEN 32
+
+struct ShardBotSums {
+    MomentSums hand;
+    MomentSums deal;
+    uint64_t wins;
+    uint64_t half_points;   /* deal_points * 2 */
+};
+
+struct ShardFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t bots;
+    uint32_t seatings;
+    uint32_t rounds;
+    uint32_t all_seatings;
+    uint64_t ticks;         /* DUPLICATE_TICKS */
+    double stack;
+    uint64_t seed;          /* deal d plays Deck::new_seeded(seed + d) */
+    uint64_t sweep_deals;   /* the whole sweep is deals 0 .. sweep_deals - 1 */
+    uint64_t deals;         /* in this file */
+    uint64_t hands;
+    uint64_t nresults;      /* deal records after the header, (1 + bots) int64s each */
+    uint64_t nranges;       /* DealRanges after the records */
+    double seconds;         /* summed over shards */
+    char names[POKER_MAX_SEATS][SHARD_NAME_LEN];
+    ShardBotSums bot[POKER_MAX_SEATS];
+};
+
+/* deals first .. end - 1 */
+struct DealRange {
+    uint64_t first;
+    uint64_t end;
+};
+
+static_assert(sizeof(ShardFileHeader) == 768, "shard file layout changed, bump SHARD_VERSION");
+static_assert(std::is_trivially_copyable_v<ShardFileHeader>, "written as raw bytes");
+
+/* shard of shards gets deals first .. first + count - 1 of a sweep */
+void shard_deals(uint64_t sweep, uint32_t shard, uint32_t shards, uint64_t* first, uint64_t* count);
+
+/* streams one run's deals to a result file */
+struct ShardWriter {
+    /* cfg.first and cfg.deals are this shard's block. names may be 0 */
+    static ShardWriter* open(const char* path, DuplicateConfig const& cfg, uint64_t sweep_deals, const char* const* names);
+    /* a duplicate_result_f, pass the writer as user */
+    static void on_result(uint64_t deal, int64_t const* net, void* user);
+    /* writes the ranges and the run's sums into the header */
+    bool finish(DuplicateStats const& st);
+    ~ShardWriter();
+private:
+    FILE* f = 0;
+    ShardFileHeader head;
+    DealRange range;
+    bool ok = true;
+    ShardWriter() = default;
+};
+
+/* a result file's header and ranges, the deal records stay on disk */
+struct ShardFile {
+    ShardFileHeader head;
+    std::vector<DealRange> ranges;
+    bool read(const char* path);
+    DuplicateStats stats() const;
+};
+
+/* merges result files of one sweep into out, refusing files from another sweep or
+   that count a deal twice. writes the combined file to out_path unless it's 0 */
+bool merge_shards(const char* const* paths, size_t n, ShardFile& out, const char* out_path = 0);
+
+#endif /* POKER_SHARD_H */
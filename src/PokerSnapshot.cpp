@@ -0,0 +1,213 @@
+#include "PokerSnapshot.h"
+#include <cstring>
+
+#define SNAPSHOT_UNSETTLED 0xFF
+
+PokerSnapshot PokerSnapshot::capture(PokerState const& game) {
+    PokerSnapshot snap;
+    memset(&snap, 0, sizeof(snap));
+    snap.state = game.state;
+    snap.bet = game.bet;
+    snap.pot = game.pot;
+    assert(game.deck.size() <= 52 && "snapshot needs a single deck");
+    for (auto c : game.deck) snap.deck[snap.ndeck++] = card_index(c);
+    assert(game.players.size() <= POKER_MAX_SEATS && "too many players to snapshot");
+    snap.nseats = (uint8_t)game.players.size();
+    for (size_t i = 0; i < snap.nseats; i++) {
+        PokerPlayer const& p = game.players.get(i);
+        Seat& s = snap.seats[i];
+        s.stack = p.stack;
+        s.bet = p.bet;
+        s.in = p.in;
+        for (auto c : p.hand) {
+            if (s.nhand == 5) break;
+            if (c.mark) s.marks |= (uint8_t)(1u << s.nhand);
+            s.hand[s.nhand++] = card_index(c);
+        }
+    }
+    snap.turn = (uint8_t)game.players.get_turn();
+    snap.first = (uint8_t)game.players.get_first();
+    snap.round = (uint8_t)game.round;
+    snap.winner = SNAPSHOT_UNSETTLED;
+    snap.nhistory = (uint8_t)game.nhistory;
+    for (size_t i = 0; i < game.nhistory; i++)
+        snap.path = poker_history_mix(snap.path, game.history[i].seat, game.history[i].kind, game.history[i].round);
+    return snap;
+}
+
+PokerSnapshot PokerSnapshot::new_hand(size_t nseats, Money stack, size_t rounds, uint8_t const* deck) {
+    PokerSnapshot snap;
+    memset(&snap, 0, sizeof(snap));
+    snap.state = DEAL;
+    assert(nseats <= POKER_MAX_SEATS && "too many players to snapshot");
+    snap.nseats = (uint8_t)nseats;
+    for (size_t i = 0; i < nseats; i++) {
+        snap.seats[i].stack = stack;
+        snap.seats[i].in = true;
+    }
+    memcpy(snap.deck, deck, 52);
+    snap.ndeck = 52;
+    snap.round = (uint8_t)rounds;
+    snap.winner = SNAPSHOT_UNSETTLED;
+    return snap;
+}
+
+PokerSnapshot PokerSnapshot::determinize(PokerObservation const& obs, uint8_t const* hidden, size_t nhidden) {
+    PokerSnapshot snap;
+    memset(&snap, 0, sizeof(snap));
+    snap.state = (decltype(snap.state))obs.state;
+    snap.bet = obs.bet;
+    snap.pot = obs.pot;
+    snap.nseats = obs.nseats;
+    snap.turn = obs.turn;
+    snap.first = obs.first;
+    snap.round = obs.round;
+    snap.winner = SNAPSHOT_UNSETTLED;
+    snap.nhistory = obs.nhistory;
+    snap.path = obs.history_key();
+    size_t h = 0;
+    for (size_t i = 0; i < snap.nseats; i++) {
+        Seat& s = snap.seats[i];
+        s.stack = obs.stack[i];
+        s.bet = obs.seat_bet[i];
+        s.in = obs.in[i];
+        if (i == obs.seat) {
+            for (; s.nhand < obs.nhand; s.nhand++) s.hand[s.nhand] = obs.hand[s.nhand];
+        } else if (snap.state != DEAL) {
+            for (; s.nhand < 5 && h < nhidden; s.nhand++) s.hand[s.nhand] = hidden[h++];
+        }
+    }
+    for (; h < nhidden && snap.ndeck < 52; h++) snap.deck[snap.ndeck++] = hidden[h];
+    return snap;
+}
+
+void PokerSnapshot::advance() {
+    while (1) {
+        switch (state) {
+        case BET_CHECK:
+        case BET_OPEN:
+            if (poker_skips_bet(seats[turn])) {
+                next((state == BET_CHECK ? INP_CHECK : INP_NONE) | INP_CONTROL_READY);
+                break;
+            }
+            return;
+        case DISCARD:
+            return;
+        case END:
+            if (winner == SNAPSHOT_UNSETTLED) settle();
+            return;
+        default:
+            step();
+        }
+    }
+}
+
+void PokerSnapshot::apply(PokerSnapshotAction const& action) {
+    if (state == END) return;
+    next(perform(action));
+    advance();
+}
+
+size_t PokerSnapshot::play(PokerSnapshotAction const* actions, size_t n) {
+    size_t i = 0;
+    advance();
+    for (; i < n && state != END; i++) apply(actions[i]);
+    return i;
+}
+
+void PokerSnapshot::step() {
+    pokerFSMinput_e inp = INP_NONE;
+    switch (state) {
+    case DEAL:
+        for (size_t i = 0; i < nseats; i++) {
+            Seat& s = seats[i];
+            POKER_DCHECK(s.nhand == 0 && "players need to be reset first");
+            while (s.nhand < 5 && ndeck) s.hand[s.nhand++] = deck[--ndeck];
+        }
+        break;
+    case PLAYER_RESET_INIT:
+    case PLAYER_RESET_DISC:
+    case PLAYER_RESET_SHOW:
+        turn = (uint8_t)poker_lap_start(seats, nseats, first);
+        break;
+    case ADV_CHECK:
+    case DISCARD_ADV:
+    case SHOW_ADV:
+        next_seat();
+        inp = (turn == first) ? INP_PLAYER_FIRST : INP_NONE;
+        break;
+    case ADV_OPEN:
+        inp = next_under(bet) ? INP_NONE : INP_PLAYER_NULL;
+        break;
+    case ROUND_CHECK:
+        inp = --round ? INP_MORE_ROUNDS : INP_NONE;
+        break;
+    case SHOW:
+        seats[turn].marks = (uint8_t)((1u << seats[turn].nhand) - 1);
+        inp = INP_CONTROL_READY;
+        break;
+    default:
+        break;
+    }
+    next(inp);
+}
+
+pokerFSMinput_e PokerSnapshot::perform(PokerSnapshotAction const& action) {
+    Seat& s = seats[turn];
+    if (state == DISCARD) {
+        uint8_t kept = 0, ndisc = 0;
+        for (uint8_t i = 0; i < s.nhand; i++) {
+            /* like the engine, only as many as the deck can replace */
+            if ((action.discard & (1u << i)) && ndisc < ndeck) ndisc++;
+            else s.hand[kept++] = s.hand[i];
+        }
+        s.nhand = kept;
+        for (; ndisc; ndisc--) s.hand[s.nhand++] = deck[--ndeck];
+        s.marks = 0;
+        return INP_CONTROL_READY;
+    }
+    Money bet_before = bet;
+    if (action.kind < ACTION_LAST)
+        poker_apply_bet(s, (pokerAction_e)action.kind, action.bet, state == BET_CHECK, bet, pot);
+    if (nhistory < POKER_MAX_HISTORY) {
+        nhistory++;
+        path = poker_history_mix(path, turn, action.kind, round);
+    }
+    return poker_bet_input(state == BET_CHECK, bet > bet_before, num_in()) | INP_CONTROL_READY;
+}
+
+void PokerSnapshot::next_seat() {
+    turn = (uint8_t)poker_next_seat(seats, nseats, turn, first);
+}
+
+bool PokerSnapshot::next_under(Money call) {
+    size_t t = turn;
+    bool found = poker_next_under(seats, nseats, t, first, call);
+    turn = (uint8_t)t;
+    return found;
+}
+
+size_t PokerSnapshot::num_in() const {
+    size_t r = 0;
+    for (size_t i = 0; i < nseats; i++) r += seats[i].in ? 1 : 0;
+    return r;
+}
+
+void PokerSnapshot::settle() {
+    Money contrib[POKER_MAX_SEATS], won[POKER_MAX_SEATS];
+    uint32_t strength[POKER_MAX_SEATS];
+    bool in[POKER_MAX_SEATS];
+    for (size_t i = 0; i < nseats; i++) {
+        Seat const& s = seats[i];
+        contrib[i] = s.bet;
+        in[i] = s.in;
+        strength[i] = 0;
+        if (!s.in) continue;
+        Card shown[5]; size_t n = 0;
+        for (size_t c = 0; c < s.nhand; c++)
+            if (s.marks & (1u << c)) shown[n++] = card_from_index(s.hand[c]);
+        strength[i] = hand_strength(shown, n);
+    }
+    winner = (uint8_t)settle_pots(nseats, contrib, in, strength, won);
+    for (size_t i = 0; i < nseats; i++) seats[i].stack += won[i];
+}
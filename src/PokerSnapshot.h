@@ -0,0 +1,74 @@
+/**
+ * PokerSnapshot.h
+ * poker
+ */
+#ifndef POKER_SNAPSHOT_H
+#define POKER_SNAPSHOT_H
+#include "PokerGame.h"
+
+/* one decision fed to a snapshot. kind is a pokerAction_e in betting states, ignored when discarding */
+struct PokerSnapshotAction {
+    uint8_t kind;
+    uint8_t discard;        /* bit i marks seat hand[i] */
+    Money bet;              /* new bet for ACTION_RAISE */
+};
+
+/**
+ * value copy of a whole hand: deck order, seats, bets, pot and FSM state.
+ * no pointers, no controllers, no heap. copy it and roll it forward with
+ * apply() to search. plays by the same rule functions as PokerGame's exec_ states
+ * (poker_apply_bet() and friends), except SHOW, which always shows all 5 cards
+ * (the default controller show).
+ * END settles the pots into the stacks like PokerGame, see settle_pots().
+ */
+struct PokerSnapshot : public PokerFSM {
+    struct Seat {
+        Money stack;
+        Money bet;
+        uint8_t hand[5];    /* card_index(), in hand order */
+        uint8_t nhand;
+        uint8_t in;
+        uint8_t marks;
+    };
+
+    Money bet;
+    Money pot;
+    Seat seats[POKER_MAX_SEATS];
+    uint8_t deck[52];       /* card_index(), top of the deck is deck[ndeck-1] */
+    uint8_t ndeck;
+    uint8_t nseats;
+    uint8_t turn;
+    uint8_t first;
+    uint8_t round;
+    uint8_t winner;
+    uint8_t nhistory;
+    uint64_t path;          /* poker_history_mix() of the betting so far */
+
+    static PokerSnapshot capture(PokerState const& game);
+    /* a hand about to be dealt from deck (top is deck[51]), like a fresh PokerGame */
+    static PokerSnapshot new_hand(size_t nseats, Money stack, size_t rounds, uint8_t const* deck);
+    /* rebuilds a hand from one seats view. the other seats get 5 cards each from
+       hidden in order, the rest of hidden becomes the deck (top is hidden[nhidden-1]) */
+    static PokerSnapshot determinize(PokerObservation const& obs, uint8_t const* hidden, size_t nhidden);
+
+    /* runs the states that need no decision. stops on BET_CHECK, BET_OPEN, DISCARD or END */
+    void advance();
+    bool over() const {return state == END;}
+    size_t to_act() const {return turn;}
+
+    /* the seat to_act() decides, then advance()s */
+    void apply(PokerSnapshotAction const& action);
+    /* applies up to n actions, stops early at END. returns how many were applied */
+    size_t play(PokerSnapshotAction const* actions, size_t n);
+
+private:
+    void step();
+    pokerFSMinput_e perform(PokerSnapshotAction const& action);
+    void next_seat();
+    bool next_under(Money call);
+    size_t num_in() const;
+    void settle();
+};
+static_assert(std::is_trivially_copyable_v<PokerSnapshot>, "snapshots are copied by value");
+
+#endif /* POKER_SNAPSHOT_H */
@@ -0,0 +1,66 @@
+#include "PokerStats.h"
+#include <cmath>
+
+RunningStats MomentSums::stats(double scale) const {
+    RunningStats s;
+    s.n = n;
+    if (!n) return s;
+    /* n sum2 - sum^2 is exact and never negative, rounding only happens in the divides */
+    __int128 spread = sum2 * (__int128)n - (__int128)sum * sum;
+    long double ln = (long double)n, sc = (long double)scale;
+    s.mean = (double)((long double)sum / ln / sc);
+    s.m2 = (double)((long double)spread / ln / (sc * sc));
+    return s;
+}
+
+double RunningStats::sd() const {return sqrt(var());}
+double RunningStats::sem() const {return n ? sqrt(var() / (double)n) : 0.;}
+
+double normal_quantile(double p) {
+    if (p <= 0.) return -INFINITY;
+    if (p >= 1.) return INFINITY;
+    /* bisection on the cdf, only called a handful of times a run */
+    double lo = -40., hi = 40.;
+    for (int i = 0; i < 200 && hi - lo > 1e-12; i++) {
+        double mid = 0.5 * (lo + hi);
+        if (0.5 * erfc(-mid / sqrt(2.)) < p) lo = mid;
+        else hi = mid;
+    }
+    return 0.5 * (lo + hi);
+}
+
+const char* verdict_name(stopVerdict_e v) {
+    static const char* names[] = {"undecided", "significant", "negligible"};
+    return names[v];
+}
+
+stopVerdict_e SequentialTest::check(RunningStats const& s) {
+    if (rule == STOP_NONE || s.n < min_samples || s.n < 2) return VERDICT_CONTINUE;
+    const double alpha = 1. - confidence;
+    if (rule == STOP_SPRT) {
+        double var = s.var();
+        if (margin <= 0. || var <= 0.) return VERDICT_CONTINUE;
+        /* two one sided tests, mean 0 against mean +margin and against -margin. either one
+           can raise a false alarm, so each gets alpha / 2 and the pair keeps alpha overall */
+        const double a = alpha / 2., b = alpha;
+        double upper = log((1. - b) / a), lower = log(b / (1. - a));
+        double scale = (double)s.n * margin / var;
+        double llr_up = scale * (s.mean - 0.5 * margin);
+        double llr_down = scale * (-s.mean - 0.5 * margin);
+        if (llr_up >= upper || llr_down >= upper) return VERDICT_SIGNIFICANT;
+        if (llr_up <= lower && llr_down <= lower) return VERDICT_NEGLIGIBLE;
+        return VERDICT_CONTINUE;
+    }
+    /* ci: only look at min, 2 min, 4 min... so alpha splits over a known number of looks */
+    const uint64_t first = min_samples > 2 ? min_samples : 2;
+    if (!next_look) next_look = first;
+    if (s.n < next_look) return VERDICT_CONTINUE;
+    while (next_look <= s.n) next_look *= 2;
+    double looks = 1.;
+    if (max_samples > first) looks += floor(log2((double)max_samples / (double)first));
+    double z = normal_quantile(1. - alpha / (2. * looks));
+    double half = z * s.sem();
+    if (fabs(s.mean) > half) return VERDICT_SIGNIFICANT;
+    if (margin > 0. && fabs(s.mean) + half < margin) return VERDICT_NEGLIGIBLE;
+    return VERDICT_CONTINUE;
+}
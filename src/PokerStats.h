@@ -0,0 +1,75 @@
+/**
+ * PokerStats.h
+ * poker
+ */
+#ifndef POKER_STATS_H
+#define POKER_STATS_H
+#include "util.h"
+
+/* mean and variance of a run, read out of MomentSums::stats(). m2 is the sum of squared
+   deviations from the mean */
+struct RunningStats {
+    uint64_t n = 0;
+    double mean = 0.;
+    double m2 = 0.;
+    /* sample variance, 0 under 2 samples */
+    inline double var() const {return n > 1 ? m2 / (double)(n - 1) : 0.;}
+    double sd() const;
+    /* standard error of the mean */
+    double sem() const;
+};
+
+/* exact count, sum and sum of squares of integer samples (scale anything else to
+   integers first). merging is plain addition, so any split of the same samples over
+   threads, processes or files merges to the same bits */
+struct MomentSums {
+    uint64_t n = 0;
+    int64_t sum = 0;
+    __int128 sum2 = 0;
+    inline void add(int64_t x) {
+        n++;
+        sum += x;
+        sum2 += (__int128)x * x;
+    }
+    inline void merge(MomentSums const& o) {n += o.n; sum += o.sum; sum2 += o.sum2;}
+    /* the RunningStats of x / scale */
+    RunningStats stats(double scale) const;
+};
+
+/* x with P(Z <= x) = p for a standard normal, p in (0, 1) */
+double normal_quantile(double p);
+
+typedef enum {
+    STOP_NONE = 0,  /* run everything */
+    STOP_SPRT,      /* wald's sequential test of 0 against +-margin, checked after every batch */
+    STOP_CI,        /* confidence interval at doubling sample counts, alpha split over the looks */
+} stopRule_e;
+
+typedef enum {
+    VERDICT_CONTINUE = 0,
+    VERDICT_SIGNIFICANT,    /* the mean is away from 0 */
+    VERDICT_NEGLIGIBLE,     /* the mean is within margin of 0 */
+} stopVerdict_e;
+
+const char* verdict_name(stopVerdict_e v);
+
+/**
+ * early stop for a stream of paired differences (or any score that is 0 when
+ * nothing is going on). confidence is 1 - alpha, and 1 - beta for the sprt, whose
+ * two sides get alpha / 2 each.
+ * margin is the smallest mean worth telling apart from 0, the sprt tests against
+ * it and the ci rule calls the run negligible once the interval sits inside it
+ * (0 turns that off). max_samples bounds how many looks the ci rule splits alpha over.
+ */
+struct SequentialTest {
+    stopRule_e rule = STOP_NONE;
+    double confidence = 0.95;
+    double margin = 0.;
+    uint64_t min_samples = 100;
+    uint64_t max_samples = 0;
+    uint64_t next_look = 0;     /* ci rule bookkeeping, 0 starts at min_samples */
+
+    stopVerdict_e check(RunningStats const& s);
+};
+
+#endif /* POKER_STATS_H */
@@ -6,6 +6,9 @@ VertexArray CardRenderer::card_vao;
 VertexBuffer<Vt_2Dclassic> CardRenderer::card_vbo;
 ElementBuffer CardRenderer::card_ibo;
 Texture CardRenderer::card_sheet;
+GLuint CardRenderer::instance_vbo = 0;
+size_t CardRenderer::instance_capacity = 0;
+CardInstance CardRenderer::current = {0.f, 0.f, 0.f, SHEET_BACK_X, SHEET_BACK_Y, 0, 0};
 
 void CardRenderer::init() {
     card_shader = Shader::from_source("vert_cards", "frag_cards");
@@ -26,9 +29,25 @@ void CardRenderer::init() {
         0, 3, 2
     };
     card_ibo.buffer_data(6, card_elems);
+
+    /* per instance attributes, stepped once per card instead of per vertex */
+    glGenBuffers(1, &instance_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+    attach_instances();
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    instance_capacity = 0;
     unbind();
 }
 
+void CardRenderer::attach_instances() {
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(CardInstance), (void*)offsetof(CardInstance, x));
+    glVertexAttribDivisor(2, 1);
+    glEnableVertexAttribArray(3);
+    glVertexAttribIPointer(3, 3, GL_UNSIGNED_BYTE, sizeof(CardInstance), (void*)offsetof(CardInstance, cellx));
+    glVertexAttribDivisor(3, 1);
+}
+
 void CardRenderer::unbind() {
     card_shader.unbind();
     card_vao.unbind();
@@ -43,6 +62,8 @@ void CardRenderer::destroy() {
     card_vbo.destroy();
     card_ibo.destroy();
     card_sheet.destroy();
+    glDeleteBuffers(1, &instance_vbo);
+    instance_vbo = 0; instance_capacity = 0;
 }
 
 void CardRenderer::sync_to_camera(Camera& cam) {
@@ -51,43 +72,92 @@ void CardRenderer::sync_to_camera(Camera& cam) {
 }
 
 void CardRenderer::sync_to_card(Card const& card) {
-    int y = 0;
-    switch(card.suit) {
-    case SUIT_CLUBS:
-        y = 4; break;
-    case SUIT_DIAMONDS:
-        y = 2; break;
-    case SUIT_HEARTS:
-        y = 1; break;
-    case SUIT_SPADES:
-        y = 3; break;
-    default:
-        break;
-    }
-    ivec2 sp = {
-        ((int)card.rank + 1) % 13,
-        y
-    };
-    card_shader.uIVec2("uSheetPos", sp);
+    SheetCell cell = card_sheet_cell(card);
+    current.cellx = cell.x;
+    current.celly = cell.y;
 }
 
 void CardRenderer::draw_at(float x, float y, float r) {
-    card_shader.bind();
-    card_shader.uMat4("uModel", genModelMat2d(vec2(x,y), r, vec2(1.)));
-    card_sheet.bind();
-    card_vao.bind();
-    gl.draw_vao_ibo(card_ibo);
-    unbind();
+    static CardInstances one;
+    one.assign(1, current);
+    one[0].x = x; one[0].y = y; one[0].rot = r;
+    draw_instances(one);
 }
 
 void CardRenderer::draw_card_at(Card const& card, float x, float y, float r) {
     sync_to_card(card); draw_at(x, y, r);
 }
 
+void CardRenderer::draw_instances(CardInstances const& cards) {
+    if (cards.empty()) return;
+    const size_t bytes = cards.size() * sizeof(CardInstance);
+    glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+    if (bytes > instance_capacity) instance_capacity = bytes * 2;
+    /* fresh storage every time, so the driver doesn't stall on the last frames draw */
+    glBufferData(GL_ARRAY_BUFFER, instance_capacity, 0, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, cards.data());
+    card_shader.bind();
+    card_sheet.bind();
+    card_vao.bind();
+    glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, (GLsizei)cards.size());
+}
+
 void DeckRenderer::draw(Deck const &deck, float x, float y, float spread, bool facedown) {
-    size_t i = 0;
-    for (auto card : deck) {
-        CardRenderer::draw_card_at(card, x - (spread/2) + (((float)i * spread) / (float)deck.size()), y, 0.);
-        i++;
+    static CardInstances batch;
+    batch.clear();
+    batch.add_deck(deck, x, y, spread, facedown);
+    CardRenderer::draw_instances(batch);
+}
+
+/**
+ *  TableRenderer
+ */
+
+void TableRenderer::init() {
+    /* the card quad and indices are shared, only the instance buffer is ours */
+    vao.create_bind();
+    CardRenderer::card_vbo.bind();
+    vao.attach(CardRenderer::card_vbo);
+    CardRenderer::card_ibo.bind();
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, TABLE_SLOTS * sizeof(CardInstance), 0, GL_DYNAMIC_DRAW);
+    CardRenderer::attach_instances();
+    vao.unbind();
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    primed = false;
+}
+
+void TableRenderer::destroy() {
+    vao.destroy();
+    glDeleteBuffers(1, &vbo);
+    vbo = 0;
+    primed = false;
+}
+
+void TableRenderer::sync(TableSnapshot const& table) {
+    const bool all = !primed || !(layout == seen_layout) || table.nseats != seen_nseats;
+    CardInstance pile[TABLE_DECK_SLOTS];
+    bool bound = false;
+    for (size_t p = 0; p < POKER_PILES; p++) {
+        if (!all && table.version[p] == seen[p]) continue;
+        if (!bound) {glBindBuffer(GL_ARRAY_BUFFER, vbo); bound = true;}
+        table_pile_instances(table, p, layout, pile);
+        glBufferSubData(GL_ARRAY_BUFFER, table_pile_first(p) * sizeof(CardInstance),
+                        table_pile_slots(p) * sizeof(CardInstance), pile);
+        seen[p] = table.version[p];
+        uploads++;
     }
+    if (bound) glBindBuffer(GL_ARRAY_BUFFER, 0);
+    seen_layout = layout;
+    seen_nseats = table.nseats;
+    primed = true;
+}
+
+void TableRenderer::draw() {
+    if (!primed) return;
+    CardRenderer::card_shader.bind();
+    CardRenderer::card_sheet.bind();
+    vao.bind();
+    glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, TABLE_SLOTS);
 }
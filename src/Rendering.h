@@ -6,6 +6,7 @@
 #ifndef RENDERING_H
 #define RENDERING_H
 #include "Deck.h"
+#include "CardInstances.h"
 #include <flgl.h>
 #include <flgl/tools.h>
 
@@ -15,6 +16,12 @@ class CardRenderer {
     static VertexBuffer<Vt_2Dclassic> card_vbo;
     static ElementBuffer card_ibo;
     static Texture card_sheet;
+    static GLuint instance_vbo;
+    static size_t instance_capacity;
+    static CardInstance current;
+    /* per instance attributes from the bound GL_ARRAY_BUFFER into the bound vao */
+    static void attach_instances();
+    friend struct TableRenderer;
 public:
     static void init();
     static void unbind();
@@ -23,13 +30,41 @@ public:
     static void sync_to_camera(Camera& cam);
     static void sync_to_card(Card const& card);
 
+    /* one card, the one from the last sync_to_card() */
     static void draw_at(float x, float y, float r = 0.f);
     static void draw_card_at(Card const& card, float x, float y, float r = 0.f);
+    /* every card in one instanced draw call. leaves the card state bound */
+    static void draw_instances(CardInstances const& cards);
 
 };
 
 struct DeckRenderer {
+    /* to draw many decks at once, add_deck() them all into one CardInstances and draw_instances() that */
     static void draw(Deck const& deck, float x, float y, float spread, bool facedown = false);
 };
 
+/**
+ * one table kept on the gpu between frames. every pile owns a fixed range
+ * of instance slots (see table_pile_instances), and sync() only rewrites the
+ * piles whose PokerState::version moved since the last sync, so an idle table
+ * uploads nothing. a new layout or seat count dirties everything.
+ */
+struct TableRenderer {
+    TableLayout layout;
+    uint64_t uploads = 0;   /* piles rewritten so far */
+
+    void init();
+    void destroy();
+    void sync(TableSnapshot const& table);
+    /* the whole table in one instanced call, CardRenderer::sync_to_camera() first */
+    void draw();
+private:
+    VertexArray vao;
+    GLuint vbo = 0;
+    uint32_t seen[POKER_PILES];
+    TableLayout seen_layout;
+    uint8_t seen_nseats = 0;
+    bool primed = false;
+};
+
 #endif /* RENDERING_H */
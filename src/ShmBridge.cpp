@@ -0,0 +1,167 @@
+#include "ShmBridge.h"
+#include <new>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+
+/* not FUTEX_PRIVATE, the word lives in memory shared between processes */
+void shm_futex_wait(std::atomic<uint32_t>* word, uint32_t seen, int timeout_us) {
+#ifdef __linux__
+    struct timespec ts = {timeout_us / 1000000, (timeout_us % 1000000) * 1000};
+    syscall(SYS_futex, (uint32_t*)word, FUTEX_WAIT, seen, timeout_us < 0 ? 0 : &ts, 0, 0);
+#else
+    /* no futex, poll at a coarse interval instead */
+    int slept = 0;
+    while (word->load() == seen && (timeout_us < 0 || slept < timeout_us)) {
+        std::this_thread::sleep_for(std::chrono::microseconds(20));
+        slept += 20;
+    }
+#endif
+}
+
+void shm_futex_wake(std::atomic<uint32_t>* word) {
+#ifdef __linux__
+    syscall(SYS_futex, (uint32_t*)word, FUTEX_WAKE, 1, 0, 0, 0);
+#else
+    (void)word;
+#endif
+}
+
+/**
+ *  ShmBridge
+ */
+
+ShmBridge::ShmBridge(ShmChannel* ch, const char* nm, bool own) : channel(ch), owner(own) {
+    strncpy(name, nm, sizeof(name) - 1); name[sizeof(name) - 1] = 0;
+}
+
+ShmBridge* ShmBridge::create(const char* name) {
+    shm_unlink(name);
+    int fd = shm_open(name, O_CREAT | O_RDWR, 0600);
+    if (fd < 0) {PLOG_ERROR("ERROR: shm_open(%s) failed\n", name); return 0;}
+    if (ftruncate(fd, sizeof(ShmChannel)) != 0) {
+        PLOG_ERROR("ERROR: ftruncate(%s) failed\n", name);
+        close(fd); shm_unlink(name); return 0;
+    }
+    void* mem = mmap(0, sizeof(ShmChannel), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {PLOG_ERROR("ERROR: mmap(%s) failed\n", name); shm_unlink(name); return 0;}
+    ShmChannel* ch = new (mem) ShmChannel;
+    ch->requests.init();
+    ch->responses.init();
+    ch->version = SHM_VERSION;
+    std::atomic_thread_fence(std::memory_order_release);
+    ch->magic = SHM_MAGIC;
+    return new ShmBridge(ch, name, true);
+}
+
+ShmBridge* ShmBridge::attach(const char* name) {
+    int fd = shm_open(name, O_RDWR, 0600);
+    if (fd < 0) {PLOG_ERROR("ERROR: no shm segment %s\n", name); return 0;}
+    void* mem = mmap(0, sizeof(ShmChannel), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {PLOG_ERROR("ERROR: mmap(%s) failed\n", name); return 0;}
+    ShmChannel* ch = (ShmChannel*)mem;
+    if (ch->magic != SHM_MAGIC || ch->version != SHM_VERSION) {
+        PLOG_ERROR("ERROR: %s is not a v%d poker shm channel\n", name, SHM_VERSION);
+        munmap(mem, sizeof(ShmChannel)); return 0;
+    }
+    return new ShmBridge(ch, name, false);
+}
+
+ShmBridge::~ShmBridge() {
+    munmap(channel, sizeof(ShmChannel));
+    if (owner) shm_unlink(name);
+}
+
+uint32_t ShmBridge::add_client() {
+    mailbox.push_back(ShmResponse{});
+    full.push_back(false);
+    return (uint32_t)(mailbox.size() - 1);
+}
+
+/* moves every answer waiting in the response ring into its client's mailbox */
+void ShmBridge::drain() {
+    ShmResponse batch[64];
+    size_t n;
+    while ((n = channel->responses.pop(batch, 64))) {
+        for (size_t i = 0; i < n; i++) {
+            if (batch[i].client >= mailbox.size()) continue;
+            mailbox[batch[i].client] = batch[i];
+            full[batch[i].client] = true;
+        }
+    }
+}
+
+void ShmBridge::post(ShmRequest const& req) {
+    while (!channel->requests.push(req)) {
+        /* the bot may be stuck pushing into a full response ring, make room for it */
+        drain();
+        channel->requests.notify();
+        std::this_thread::yield();
+    }
+    channel->requests.notify();
+}
+
+bool ShmBridge::take(uint32_t client, uint32_t seq, ShmResponse& out) {
+    drain();
+    assert(client < mailbox.size() && "unknown shm client");
+    if (!full[client] || mailbox[client].seq != seq) return false;
+    full[client] = false;
+    out = mailbox[client];
+    return true;
+}
+
+void ShmBridge::wait(int timeout_us) {
+    channel->responses.wait(4096, timeout_us);
+}
+
+/**
+ *  ShmPlayer
+ */
+
+ShmPlayer::ShmPlayer(ShmBridge& br, bool block)
+    : PokerPlayerController(), bridge(br), client(br.add_client()), seq(0), pending(false), blocking(block) {}
+
+bool ShmPlayer::exchange(shmRequest_e kind, PokerObservation const& obs, ShmResponse& resp) {
+    if (!pending) {
+        ShmRequest req = {};
+        req.client = client;
+        req.seq = ++seq;
+        req.kind = (uint8_t)kind;
+        req.obs = obs;
+        bridge.post(req);
+        pending = true;
+    }
+    do {
+        if (bridge.take(client, seq, resp)) {
+            pending = false;
+            return true;
+        }
+        if (blocking) bridge.wait(1000);
+    } while (blocking);
+    return false;
+}
+
+PokerBetAction* ShmPlayer::bet(PokerObservation const& obs, PokerPlayer const& player) {
+    ShmResponse resp;
+    if (!exchange(SHM_BET, obs, resp)) return 0;
+    return new_legal_bet_action(obs, player.index, resp.action, (Money)resp.amount);
+}
+
+PokerPlayerController::ControlResult ShmPlayer::discard(PokerObservation const& obs, PokerPlayer const& player) {
+    ShmResponse resp;
+    if (!exchange(SHM_DISCARD, obs, resp)) return CONTROL_BUSY;
+    for (size_t i = 0; i < player.hand.size() && i < 5; i++) {
+        if (resp.discard & (1u << i)) player.hand.mark(i);
+    }
+    return CONTROL_OK;
+}
@@ -0,0 +1,157 @@
+/**
+ * ShmBridge.h
+ * poker
+ */
+#ifndef SHM_BRIDGE_H
+#define SHM_BRIDGE_H
+#include <atomic>
+#include "PokerGame.h"
+
+/**
+ * shared memory bridge to bots living in another process.
+ * one ShmChannel per bot process holds a request ring (engine -> bot) and a
+ * response ring (bot -> engine). both rings are single producer single consumer.
+ * every table on an engine thread shares its bot's channel, so one wakeup on the
+ * bot side drains decisions for all of them.
+ */
+
+typedef enum {
+    SHM_BET = 0,
+    SHM_DISCARD,
+} shmRequest_e;
+
+/* engine -> bot. fixed layout, no pointers */
+struct ShmRequest {
+    uint32_t client;        /* ShmPlayer id, echoed back */
+    uint32_t seq;           /* per client decision counter, echoed back */
+    uint8_t kind;           /* shmRequest_e */
+    uint8_t _pad[7];
+    PokerObservation obs;
+};
+
+/* bot -> engine */
+struct ShmResponse {
+    uint32_t client;
+    uint32_t seq;
+    uint8_t action;         /* pokerAction_e, SHM_BET only */
+    uint8_t discard;        /* bit i marks obs.hand[i], SHM_DISCARD only */
+    uint8_t _pad[6];
+    double amount;          /* new bet for ACTION_RAISE */
+};
+
+void shm_futex_wait(std::atomic<uint32_t>* word, uint32_t seen, int timeout_us);
+void shm_futex_wake(std::atomic<uint32_t>* word);
+
+template <typename T, uint32_t N>
+struct ShmRing {
+    static_assert((N & (N - 1)) == 0, "ring size must be a power of 2");
+    alignas(64) std::atomic<uint32_t> head;     /* producer owned */
+    alignas(64) std::atomic<uint32_t> tail;     /* consumer owned */
+    alignas(64) std::atomic<uint32_t> parked;   /* consumer is asleep on head */
+    alignas(64) T slots[N];
+
+    inline void init() {head = 0; tail = 0; parked = 0;}
+
+    inline bool push(T const& v) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == N) return false;
+        slots[h & (N - 1)] = v;
+        head.store(h + 1);
+        return true;
+    }
+    inline size_t pop(T* out, size_t max) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        size_t avail = head.load(std::memory_order_acquire) - t;
+        size_t n = avail < max ? avail : max;
+        for (size_t i = 0; i < n; i++) out[i] = slots[(t + i) & (N - 1)];
+        tail.store(t + (uint32_t)n, std::memory_order_release);
+        return n;
+    }
+    inline bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_relaxed);
+    }
+    /* producer, after pushing. only costs a syscall if the consumer is parked */
+    inline void notify() {
+        if (parked.load()) shm_futex_wake(&head);
+    }
+    /* consumer. spins first, then sleeps until the producer moves head (or timeout, <0 is forever) */
+    inline void wait(uint32_t spins = 4096, int timeout_us = -1) {
+        uint32_t seen = tail.load(std::memory_order_relaxed);
+        for (uint32_t i = 0; i < spins; i++)
+            if (head.load(std::memory_order_acquire) != seen) return;
+        parked.store(1);
+        if (head.load() == seen) shm_futex_wait(&head, seen, timeout_us);
+        parked.store(0);
+    }
+};
+
+#define SHM_RING_SIZE 1024
+#define SHM_MAGIC 0x504b5348 /* PKSH */
+#define SHM_VERSION 2
+
+struct ShmChannel {
+    uint32_t magic;
+    uint32_t version;
+    ShmRing<ShmRequest, SHM_RING_SIZE> requests;
+    ShmRing<ShmResponse, SHM_RING_SIZE> responses;
+};
+
+struct ShmBridge {
+    /* engine side creates and owns the segment, name is a posix shm name like "/poker_bot0". 0 on failure */
+    static ShmBridge* create(const char* name);
+    /* bot side maps an existing segment. 0 on failure */
+    static ShmBridge* attach(const char* name);
+    ~ShmBridge();
+
+    /* engine side */
+    uint32_t add_client();
+    void post(ShmRequest const& req);
+    bool take(uint32_t client, uint32_t seq, ShmResponse& out);
+    void wait(int timeout_us = -1);
+
+    /* bot side. blocks for at least one request, answers everything queued with
+       ShmResponse handler(ShmRequest const&), returns how many were answered */
+    template <typename F>
+    size_t serve(F&& handler, int timeout_us = -1) {
+        ShmRequest batch[64];
+        size_t n = channel->requests.pop(batch, 64);
+        if (!n) {
+            channel->requests.wait(4096, timeout_us);
+            n = channel->requests.pop(batch, 64);
+        }
+        for (size_t i = 0; i < n; i++) {
+            ShmResponse resp = handler(batch[i]);
+            resp.client = batch[i].client; resp.seq = batch[i].seq;
+            while (!channel->responses.push(resp)) channel->responses.notify();
+        }
+        if (n) channel->responses.notify();
+        return n;
+    }
+
+    ShmChannel* channel;
+private:
+    ShmBridge(ShmChannel* ch, const char* nm, bool own);
+    char name[64];
+    bool owner;
+    std::vector<ShmResponse> mailbox;
+    std::vector<bool> full;
+    void drain();
+};
+
+/**
+ * controller answered by a bot through a ShmBridge. non blocking by default:
+ * bet()/discard() post once and report busy until the answer is in, so one thread
+ * can keep many PokerGames in flight with step_until_busy() + ShmBridge::wait().
+ */
+struct ShmPlayer : public PokerPlayerController {
+    ShmPlayer(ShmBridge& bridge, bool blocking = false);
+    virtual PokerBetAction* bet(PokerObservation const& obs, PokerPlayer const& player) override final;
+    virtual ControlResult discard(PokerObservation const& obs, PokerPlayer const& player) override final;
+private:
+    ShmBridge& bridge;
+    uint32_t client, seq;
+    bool pending, blocking;
+    bool exchange(shmRequest_e kind, PokerObservation const& obs, ShmResponse& resp);
+};
+
+#endif /* SHM_BRIDGE_H */
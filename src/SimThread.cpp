@@ -0,0 +1,105 @@
+#include "SimThread.h"
+#include "Trace.h"
+#include <chrono>
+
+/* how long a waiting sim thread naps before asking a GuiPlayer again */
+#define SIM_BUSY_SLEEP_US 500
+
+/**
+ *  GuiPlayer
+ */
+
+GuiPlayer::GuiPlayer(GuiInputQueue& q) : PokerPlayerController(), inputs(q) {}
+
+bool GuiPlayer::take(pokerDecision_e d, GuiInput& out) {
+    waiting.store((int)d, std::memory_order_relaxed);
+    while (inputs.pop(out)) {
+        if (out.decision != d) continue;
+        waiting.store(-1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+PokerBetAction* GuiPlayer::bet(PokerObservation const& obs, PokerPlayer const& player) {
+    GuiInput in;
+    if (!take(DECISION_BET, in)) return 0;
+    /* the window may have been a snapshot behind, so the raise is relative to the live bet
+       and the click is made legal here: check and call are one button, fold checks when it
+       can, and a raise the stack can't cover goes all in */
+    Money to = in.action == ACTION_RAISE ? (Money)obs.bet + in.amount : 0.;
+    return new_legal_bet_action(obs, player.index, in.action, to);
+}
+
+PokerPlayerController::ControlResult GuiPlayer::discard(PokerObservation const& obs, PokerPlayer const& player) {
+    (void)obs;
+    GuiInput in;
+    if (!take(DECISION_DISCARD, in)) return CONTROL_BUSY;
+    for (size_t i = 0; i < player.hand.size(); i++) {
+        if (in.mask & (1u << i)) player.hand.mark(i);
+    }
+    return CONTROL_OK;
+}
+
+PokerPlayerController::ControlResult GuiPlayer::show(PokerObservation const& obs, PokerPlayer const& player) {
+    GuiInput in;
+    if (!take(DECISION_SHOW, in)) return CONTROL_BUSY;
+    if (!in.mask) return PokerPlayerController::show(obs, player);
+    player.hand.mark_all(false);
+    for (size_t i = 0; i < player.hand.size(); i++) {
+        if (in.mask & (1u << i)) player.hand.mark(i);
+    }
+    return CONTROL_OK;
+}
+
+/**
+ *  SimThread
+ */
+
+SimThread::SimThread(size_t r, uint64_t s) : players(), rounds(r), seed(s) {}
+
+SimThread::~SimThread() {stop();}
+
+void SimThread::start() {
+    if (running.load()) return;
+    buyins.clear();
+    for (auto const& p : players) buyins.push_back(p.stack);
+    publish(PokerState(players, rounds));
+    running.store(true);
+    thread = std::thread(&SimThread::run, this);
+}
+
+void SimThread::stop() {
+    running.store(false);
+    if (thread.joinable()) thread.join();
+}
+
+void SimThread::publish(PokerState const& game) {
+    tables.write() = TableSnapshot::capture(game);
+    tables.publish();
+}
+
+void SimThread::run() {
+    trace_thread_name("sim");
+    for (uint64_t h = 0; running.load(std::memory_order_relaxed); h++) {
+        TRACE_ZONE("hand", "sim");
+        /* everyone back in with a fresh hand, short stacks rebuy to where they started */
+        for (size_t i = 0; i < players.size(); i++) {
+            PokerPlayer& p = players[i];
+            p.hand = Deck::new_empty();
+            p.bet = 0.;
+            p.in = true;
+            if (p.stack < buyins[i]) p.stack = buyins[i];
+        }
+        PokerGame game(players, rounds, seed ? seed + h : 0);
+        while (running.load(std::memory_order_relaxed)) {
+            PokerGame::Result r = game.step();
+            steps.fetch_add(1, std::memory_order_relaxed);
+            publish(game);
+            uint32_t delay = r.status == PokerGame::Result::BUSY ? SIM_BUSY_SLEEP_US : step_delay_us.load(std::memory_order_relaxed);
+            if (delay) std::this_thread::sleep_for(std::chrono::microseconds(delay));
+            if (r.status == PokerGame::Result::END) break;
+        }
+        hands.fetch_add(1, std::memory_order_relaxed);
+    }
+}
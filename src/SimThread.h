@@ -0,0 +1,83 @@
+/**
+ * SimThread.h
+ * poker
+ */
+#ifndef SIM_THREAD_H
+#define SIM_THREAD_H
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "PokerGame.h"
+#include "PokerInstrument.h"
+#include "TableSnapshot.h"
+#include "TripleBuffer.h"
+#include "SpscQueue.h"
+
+/**
+ * runs hands on their own thread so the window never waits on a controller.
+ * after every step the table goes out as a TableSnapshot through a triple
+ * buffer, the render thread picks up the newest one with update() / table().
+ * clicks come back the other way through a wait free queue to GuiPlayer seats.
+ * bots step as fast as they think, step_delay_us slows it down to watch.
+ */
+
+/* one answer from the window. mask is cards by hand position */
+struct GuiInput {
+    pokerDecision_e decision;
+    pokerAction_e action;       /* DECISION_BET, made legal against the seat when it's taken */
+    uint8_t mask;               /* DECISION_DISCARD, or DECISION_SHOW (0 shows the best 5) */
+    double amount;              /* ACTION_RAISE, how far over the table's bet at the time */
+};
+typedef SpscQueue<GuiInput, 64> GuiInputQueue;
+
+/**
+ * a seat played from the window. it never blocks the sim thread: until an
+ * answer for the decision it's asked is in the queue it says busy, and the
+ * engine asks again next step. answers for some other decision are stale
+ * clicks and get dropped.
+ */
+struct GuiPlayer : public PokerPlayerController {
+    GuiPlayer(GuiInputQueue& inputs);
+    virtual PokerBetAction* bet(PokerObservation const& obs, PokerPlayer const& player) override final;
+    virtual ControlResult discard(PokerObservation const& obs, PokerPlayer const& player) override final;
+    virtual ControlResult show(PokerObservation const& obs, PokerPlayer const& player) override final;
+
+    /* the pokerDecision_e this seat is waiting on, -1 when it isn't. readable from any thread */
+    std::atomic<int> waiting{-1};
+private:
+    GuiInputQueue& inputs;
+    bool take(pokerDecision_e d, GuiInput& out);
+};
+
+struct SimThread {
+    SimThread(size_t rounds = 2, uint64_t seed = 0);
+    ~SimThread();
+
+    /* seat everyone before start(), the sim thread owns the list after that */
+    PlayerList players;
+    /* the render thread pushes, GuiPlayer seats pop */
+    GuiInputQueue inputs;
+    std::atomic<uint32_t> step_delay_us{0};
+    std::atomic<uint64_t> steps{0};
+    std::atomic<uint64_t> hands{0};
+
+    void start();
+    /* finishes the current step and joins */
+    void stop();
+
+    /* render thread only. true if a newer table came in, which table() then returns */
+    inline bool update() {return tables.update();}
+    inline TableSnapshot const& table() const {return tables.read();}
+
+private:
+    std::thread thread;
+    std::atomic<bool> running{false};
+    TripleBuffer<TableSnapshot> tables;
+    size_t rounds;
+    uint64_t seed;
+    std::vector<Money> buyins;
+    void run();
+    void publish(PokerState const& game);
+};
+
+#endif /* SIM_THREAD_H */
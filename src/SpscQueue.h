@@ -0,0 +1,42 @@
+/**
+ * SpscQueue.h
+ * poker
+ */
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+#include <atomic>
+#include <cstddef>
+
+/**
+ * bounded wait free queue, one producer thread and one consumer thread.
+ * push() and pop() are a couple of loads and a store, they never retry or
+ * block, they just fail when the queue is full / empty. N is a power of 2.
+ */
+template <typename T, size_t N>
+struct SpscQueue {
+    static_assert(N && !(N & (N - 1)), "queue size must be a power of 2");
+
+    /* producer, false if full */
+    inline bool push(T const& v) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == N) return false;
+        ring[h & (N - 1)] = v;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+    /* consumer, false if empty */
+    inline bool pop(T& out) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) return false;
+        out = ring[t & (N - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    T ring[N];
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+};
+
+#endif /* SPSC_QUEUE_H */
@@ -0,0 +1,25 @@
+#include "TableSnapshot.h"
+#include <cstring>
+
+TableSnapshot TableSnapshot::capture(PokerState const& game) {
+    TableSnapshot t;
+    memset(&t, 0, sizeof(t));
+    memcpy(t.version, game.version, sizeof(t.version));
+    t.nseats = (uint8_t)(game.players.size() < POKER_MAX_SEATS ? game.players.size() : POKER_MAX_SEATS);
+    t.state = (uint8_t)game.state;
+    t.turn = (uint8_t)game.players.get_turn();
+    t.ndeck = (uint8_t)game.deck.size();
+    t.pot = (double)game.pot;
+    t.bet = (double)game.bet;
+    for (size_t i = 0; i < t.nseats; i++) {
+        PokerPlayer const& p = game.players[i];
+        t.in[i] = p.in;
+        t.stack[i] = (double)p.stack;
+        t.seat_bet[i] = (double)p.bet;
+        for (auto const& c : p.hand) {
+            if (t.ncards[i] == TABLE_SEAT_CARDS) break;
+            t.cards[i][t.ncards[i]++] = card_index(c) | (c.mark ? TABLE_CARD_MARKED : 0);
+        }
+    }
+    return t;
+}
@@ -0,0 +1,35 @@
+/**
+ * TableSnapshot.h
+ * poker
+ */
+#ifndef TABLE_SNAPSHOT_H
+#define TABLE_SNAPSHOT_H
+#include <type_traits>
+#include "PokerGame.h"
+
+#define TABLE_SEAT_CARDS 8
+#define TABLE_CARD_MARKED 0x80  /* or'd into a card_index() */
+
+/**
+ * what a renderer needs from a table, copied out in one go.
+ * fixed size and trivially copyable, so it can be handed between threads by value.
+ */
+struct TableSnapshot {
+    uint32_t version[POKER_PILES];      /* PokerState::version at capture */
+    uint8_t nseats;
+    uint8_t state;                      /* PokerFSM state */
+    uint8_t turn;
+    uint8_t ndeck;
+    uint8_t ncards[POKER_MAX_SEATS];
+    uint8_t in[POKER_MAX_SEATS];
+    uint8_t cards[POKER_MAX_SEATS][TABLE_SEAT_CARDS];
+    double pot;
+    double bet;
+    double stack[POKER_MAX_SEATS];
+    double seat_bet[POKER_MAX_SEATS];
+
+    static TableSnapshot capture(PokerState const& game);
+};
+static_assert(std::is_trivially_copyable_v<TableSnapshot>, "snapshots are passed around as bytes");
+
+#endif /* TABLE_SNAPSHOT_H */
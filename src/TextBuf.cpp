@@ -0,0 +1,25 @@
+#include "TextBuf.h"
+
+TextBuf& TextBuf::fmt(const char* f, ...) {
+    va_list args;
+    for (int tries = 0; tries < 2; tries++) {
+        va_start(args, f);
+        int n = vsnprintf(buf + len, TEXT_BUF_SIZE - len, f, args);
+        va_end(args);
+        if (n < 0) return *this;
+        if (len + (size_t)n < TEXT_BUF_SIZE) {len += (size_t)n; return *this;}
+        /* didn't fit, the partial write is dropped with the flush */
+        if (!tries) flush();
+    }
+    /* bigger than the whole buffer, straight to the file */
+    va_start(args, f);
+    vfprintf(out, f, args);
+    va_end(args);
+    return *this;
+}
+
+void TextBuf::flush() {
+    if (!len) return;
+    fwrite(buf, 1, len, out);
+    len = 0;
+}
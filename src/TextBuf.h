@@ -0,0 +1,53 @@
+/**
+ * TextBuf.h
+ * poker
+ */
+#ifndef TEXT_BUF_H
+#define TEXT_BUF_H
+#include <cstdarg>
+#include <cstring>
+#include "util.h"
+
+#define TEXT_BUF_SIZE 4096
+
+/**
+ * buffered text out. builds lines in a fixed buffer and hands them to stdio
+ * in one fwrite when full, on flush() or when it goes out of scope, so a
+ * print that used to be dozens of printf calls is one write.
+ */
+struct TextBuf {
+    inline TextBuf(FILE* f = stdout) : out(f), len(0) {}
+    inline ~TextBuf() {flush();}
+    TextBuf(TextBuf const&) = delete;
+    TextBuf& operator=(TextBuf const&) = delete;
+
+    inline TextBuf& put(char c) {
+        if (len == TEXT_BUF_SIZE) flush();
+        buf[len++] = c;
+        return *this;
+    }
+    inline TextBuf& put(const char* s, size_t n) {
+        if (len + n > TEXT_BUF_SIZE) flush();
+        if (n > TEXT_BUF_SIZE) {fwrite(s, 1, n, out); return *this;}
+        memcpy(buf + len, s, n);
+        len += n;
+        return *this;
+    }
+    inline TextBuf& put(const char* s) {return put(s, strlen(s));}
+    /* room for n more bytes without a flush in between, then commit() what was written */
+    inline char* reserve(size_t n) {
+        if (len + n > TEXT_BUF_SIZE) flush();
+        return buf + len;
+    }
+    inline void commit(size_t n) {len += n;}
+    /* printf into the buffer */
+    TextBuf& fmt(const char* f, ...) __attribute__((format(printf, 2, 3)));
+    void flush();
+
+    FILE* out;
+private:
+    size_t len;
+    char buf[TEXT_BUF_SIZE];
+};
+
+#endif /* TEXT_BUF_H */
@@ -0,0 +1,145 @@
+#include "Trace.h"
+
+#ifdef POKER_TRACE
+
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct TraceEvent {
+    const char* name;
+    const char* cat;
+    uint64_t start_ns;
+    float dur_us;
+};
+
+/* one per thread, single writer. never freed so exited threads still dump */
+struct TraceRing {
+    std::vector<TraceEvent> events;
+    std::atomic<uint64_t> head{0};
+    uint32_t tid;
+    const char* name;
+};
+
+std::atomic<bool> trace_enabled{false};
+volatile sig_atomic_t trace_signalled = 0;
+
+static std::mutex rings_lock;
+static std::vector<TraceRing*> rings;
+static std::string trace_path;
+static size_t ring_events = 1 << 16;
+static std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+static TraceRing& local_ring() {
+    thread_local TraceRing* mine = 0;
+    if (!mine) {
+        mine = new TraceRing();
+        std::lock_guard<std::mutex> guard(rings_lock);
+        mine->events.resize(ring_events);
+        mine->tid = (uint32_t)rings.size() + 1;
+        mine->name = 0;
+        rings.push_back(mine);
+    }
+    return *mine;
+}
+
+uint64_t trace_now_ns() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void trace_emit(const char* name, const char* cat, uint64_t start_ns, float dur_us) {
+    TraceRing& r = local_ring();
+    uint64_t h = r.head.load(std::memory_order_relaxed);
+    r.events[h % r.events.size()] = TraceEvent{name, cat, start_ns, dur_us};
+    r.head.store(h + 1, std::memory_order_release);
+}
+
+static void on_sigusr1(int) {trace_signalled = 1;}
+
+void trace_poll() {
+    trace_signalled = 0;
+    trace_dump();
+}
+
+static void dump_at_exit() {trace_dump();}
+
+void trace_start(const char* path, size_t events) {
+    {
+        std::lock_guard<std::mutex> guard(rings_lock);
+        trace_path = path;
+        ring_events = events ? events : 1;
+    }
+    static bool once = false;
+    if (!once) {
+        once = true;
+        atexit(dump_at_exit);
+#ifdef SIGUSR1
+        signal(SIGUSR1, on_sigusr1);
+#endif
+    }
+    trace_enabled.store(true);
+}
+
+void trace_thread_name(const char* name) {
+    local_ring().name = name;
+}
+
+/* names are literals, only quotes and backslashes need escaping */
+static void json_string(FILE* f, const char* s) {
+    fputc('"', f);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') fputc('\\', f);
+        fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+bool trace_dump(const char* path) {
+    std::lock_guard<std::mutex> guard(rings_lock);
+    std::string out = path ? path : trace_path;
+    if (out.empty()) return false;
+    FILE* f = fopen(out.c_str(), "w");
+    if (!f) {PLOG_ERROR("ERROR: can't write trace to %s\n", out.c_str()); return false;}
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    size_t total = 0;
+    for (TraceRing* r : rings) {
+        if (r->name) {
+            fprintf(f, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", first ? "" : ",\n", r->tid);
+            json_string(f, r->name);
+            fprintf(f, "}}");
+            first = false;
+        }
+        uint64_t head = r->head.load(std::memory_order_acquire);
+        uint64_t size = r->events.size();
+        for (uint64_t i = head > size ? head - size : 0; i < head; i++) {
+            TraceEvent const& e = r->events[i % size];
+            fprintf(f, "%s{\"ph\":\"X\",\"name\":", first ? "" : ",\n");
+            json_string(f, e.name);
+            fprintf(f, ",\"cat\":");
+            json_string(f, e.cat);
+            fprintf(f, ",\"ts\":%lu.%03lu,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+                    (unsigned long)(e.start_ns / 1000), (unsigned long)(e.start_ns % 1000), e.dur_us, r->tid);
+            first = false;
+            total++;
+        }
+    }
+    fprintf(f, "\n]}\n");
+    bool ok = fclose(f) == 0;
+    lg("trace: %zu events from %zu threads to %s\n", total, rings.size(), out.c_str());
+    return ok;
+}
+
+#else
+
+void trace_start(const char* path, size_t events) {
+    (void)path; (void)events;
+    PLOG_WARN("built without POKER_TRACE, not tracing\n");
+}
+bool trace_dump(const char* path) {(void)path; return false;}
+void trace_thread_name(const char* name) {(void)name;}
+
+#endif /* POKER_TRACE */
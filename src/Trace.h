@@ -0,0 +1,65 @@
+/**
+ * Trace.h
+ * poker
+ */
+#ifndef TRACE_H
+#define TRACE_H
+#include <atomic>
+#include "util.h"
+
+/**
+ * timeline tracing, build with -DPOKER_TRACE.
+ * TRACE_ZONE(name, cat) times its scope with a Stopwatch and drops a complete
+ * event into the calling thread's ring (the newest events win when it wraps).
+ * trace_dump() writes every ring as chrome trace json, load it in
+ * chrome://tracing or ui.perfetto.dev. after trace_start() that happens on exit,
+ * and whenever the process gets SIGUSR1 (at the next TRACE_POLL()).
+ * names and categories must be string literals, or otherwise outlive the dump.
+ * without the flag the macros compile to nothing and trace_start() just says so.
+ */
+
+/* turns recording on. path is where exit / SIGUSR1 dumps go, events is per thread */
+void trace_start(const char* path = "poker_trace.json", size_t events = 1 << 16);
+/* 0 path dumps to the trace_start() path. returns false if it couldn't write */
+bool trace_dump(const char* path = 0);
+/* names the calling thread in the dump */
+void trace_thread_name(const char* name);
+
+#ifdef POKER_TRACE
+
+#include <csignal>
+#include "Stopwatch.h"
+
+extern std::atomic<bool> trace_enabled;
+extern volatile sig_atomic_t trace_signalled;
+
+uint64_t trace_now_ns();
+void trace_emit(const char* name, const char* cat, uint64_t start_ns, float dur_us);
+void trace_poll();
+
+struct TraceZone {
+    const char* name;
+    const char* cat;
+    uint64_t start;
+    Stopwatch sw;
+    inline TraceZone(const char* n, const char* c) : name(n), cat(c), start(0), sw(MICROSECONDS) {
+        if (!trace_enabled.load(std::memory_order_relaxed)) {name = 0; return;}
+        start = trace_now_ns();
+        sw.start();
+    }
+    inline ~TraceZone() {if (name) trace_emit(name, cat, start, sw.stop());}
+};
+
+#define TRACE_CONCAT2(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT2(a, b)
+#define TRACE_ZONE(name, cat) TraceZone TRACE_CONCAT(_trace_zone, __LINE__)(name, cat)
+#define TRACE_POLL() do {if (trace_signalled) trace_poll();} while (0)
+
+#else
+
+#define TRACE_ZONE(name, cat) do {} while (0)
+#define TRACE_POLL() do {} while (0)
+
+#endif /* POKER_TRACE */
+
+#endif /* TRACE_H */
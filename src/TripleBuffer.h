@@ -0,0 +1,46 @@
+/**
+ * TripleBuffer.h
+ * poker
+ */
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+#include <atomic>
+#include <cstdint>
+
+/**
+ * lock free triple buffer, one writer thread and one reader thread.
+ * the writer fills its back slot and publish() swaps it with the middle one,
+ * update() on the reader swaps the middle into the front if anything new landed.
+ * neither side ever waits, and the reader only sees whole values, the newest
+ * one published when it looked. values in between are skipped, not queued.
+ */
+template <typename T>
+struct TripleBuffer {
+    TripleBuffer() : back(0), middle(1), front(2) {}
+
+    /* writer: fill this in, then publish() */
+    inline T& write() {return slots[back].value;}
+    inline void publish() {
+        back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    /* reader: true if something was published since the last update(), it's in read() */
+    inline bool update() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+    inline T const& read() const {return slots[front].value;}
+
+private:
+    static constexpr uint8_t INDEX = 0x3;
+    static constexpr uint8_t FRESH = 0x4;
+    /* each slot and each side's index on its own line, the two threads never share one */
+    struct alignas(64) Slot {T value;};
+    Slot slots[3];
+    alignas(64) uint8_t back;
+    alignas(64) std::atomic<uint8_t> middle;
+    alignas(64) uint8_t front;
+};
+
+#endif /* TRIPLE_BUFFER_H */
@@ -5,12 +5,26 @@
 #include "PokerDriver.h"
 #include "PokerGame.h"
 #include "PokerAI.h"
+#include "Trace.h"
 
 #include <iostream>
+#include <cstring>
 
 
 
-int main() {
+int main(int argc, char** argv) {
+#ifdef POKER_TRACE
+    trace_start("poker_trace.json");
+    trace_thread_name("main");
+#endif
+
+    /* --gui plays seat 0 in a window against bots, the game on its own thread */
+    if (argc > 1 && !strcmp(argv[1], "--gui")) {
+        Driver* dr = new PokerDriver();
+        dr->start();
+        delete dr;
+        return 0;
+    }
 
     PlayerList players;
 
@@ -22,12 +36,6 @@ int main() {
 
     game.run().print();
 
-    // Driver* dr = new PokerDriver();
-
-    // dr->start();
-
-    // delete dr;
-
 
     return 0;
 }
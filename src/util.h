@@ -10,9 +10,11 @@
 #include <stdio.h>
 #include <vector>
 #include <random>
+#include "Log.h"
 
+/* always on, logs and carries on. hot paths use POKER_DCHECK (Log.h) */
 #ifndef assert
-    #define assert(expr) if (!(expr)) lg("ERROR: ASSERTION FAILED!!! %s\n", #expr)
+    #define assert(expr) POKER_CHECK(expr)
 #endif
 #define tassert(expr) if (!(expr)) lg("ERROR: ASSERTION FAILED!!! %s\n", #expr); else lg("PASS: %s\n", #expr)
 
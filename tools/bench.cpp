@@ -0,0 +1,304 @@
+/**
+ * bench.cpp
+ * poker
+ */
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "PokerGame.h"
+#include "PokerProfile.h"
+
+/**
+ * poker_bench: microbenchmarks for the deck, the evaluator and the player list,
+ * and whole hands with scripted controllers. every bench is calibrated to run
+ * at least --min-ms, repeated --reps times, and the median ns/op is reported.
+ * results go out as json. --compare BASELINE reads an earlier run and flags
+ * anything slower by more than --threshold, exiting 1 if there is one.
+ */
+
+static void usage() {
+    lg("usage: poker_bench [--filter SUBSTR] [--reps N] [--min-ms N] [--out FILE]\n"
+       "                   [--compare BASELINE.json] [--threshold FRACTION] [--profile]\n");
+}
+
+/* keeps results alive so the optimizer can't drop the work */
+static volatile uint64_t bench_sink;
+/* hands the game benches have played, calibration runs included */
+static uint64_t bench_hands;
+
+struct BenchResult {
+    std::string name;
+    uint64_t iters;             /* ops per rep */
+    double ns_per_op;           /* median over reps */
+    double min_ns, max_ns;
+    double hands_per_sec;       /* game benches only */
+};
+
+typedef uint64_t (*bench_f)(uint64_t iters);
+
+struct Bench {
+    const char* name;
+    bench_f fn;
+    bool hands;                 /* one op is one hand */
+};
+
+/**
+ *  the benches
+ */
+
+static uint64_t bench_shuffle(uint64_t n) {
+    uint64_t acc = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        Deck d = Deck::new_shuffled();
+        acc += card_index(d.peek());
+    }
+    return acc;
+}
+
+static uint64_t bench_seeded(uint64_t n) {
+    uint64_t acc = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        Deck d = Deck::new_seeded(i + 1);
+        acc += card_index(d.peek());
+    }
+    return acc;
+}
+
+static uint64_t bench_deal(uint64_t n) {
+    Deck full = Deck::new_seeded(7);
+    uint64_t acc = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        Deck d = full;
+        Deck hand = d.deal(5);
+        acc += hand.size() + d.size();
+    }
+    return acc;
+}
+
+static uint64_t bench_deck_minus(uint64_t n) {
+    Deck full = Deck::new_seeded(11);
+    Deck tmp = full;
+    Deck hand = tmp.deal(5);
+    uint64_t acc = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        Deck d = full;
+        d -= hand;
+        acc += d.size();
+    }
+    return acc;
+}
+
+static uint64_t bench_best_hand(uint64_t n) {
+    /* a fixed pile of random hands, so the branches see real data */
+    static std::vector<Card> hands;
+    if (hands.empty()) {
+        for (uint64_t s = 1; s <= 1024; s++) {
+            Deck d = Deck::new_seeded(s);
+            for (auto c : d.deal(5)) hands.push_back(c);
+        }
+    }
+    uint64_t acc = 0;
+    const size_t nhands = hands.size() / 5;
+    for (uint64_t i = 0; i < n; i++) acc += find_best_hand(&hands[(i % nhands) * 5], 5);
+    return acc;
+}
+
+/* never asked, next_under only looks at bets and who's in */
+struct IdlePlayer : public PokerPlayerController {
+    virtual PokerBetAction* bet(PokerObservation const& obs, PokerPlayer const& player) override final {
+        (void)obs; return new_bet_action(ACTION_FOLD, player.index);
+    }
+    virtual ControlResult discard(PokerObservation const& obs, PokerPlayer const& player) override final {
+        (void)obs; (void)player; return CONTROL_OK;
+    }
+};
+
+static uint64_t bench_next_under(uint64_t n) {
+    static PlayerList players;
+    if (players.empty()) {
+        for (size_t s = 0; s < POKER_MAX_SEATS; s++) players.add(new IdlePlayer(), 20.);
+        players.set_first(0); players.set_turn(0);
+        for (size_t s = 0; s < POKER_MAX_SEATS; s++) players[s].bet = (Money)(s % 3);
+        players[2].in = false;
+    }
+    uint64_t acc = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        PokerPlayer* p = players.next_under((Money)(1 + (i & 1)));
+        acc += p ? p->index : 7;
+    }
+    return acc;
+}
+
+/**
+ * plays the same hand shape every time: check or call, raise once a round
+ * from seat 0, throw the first two cards. no search, so the engine is the cost
+ */
+struct ScriptedPlayer : public PokerPlayerController {
+    virtual PokerBetAction* bet(PokerObservation const& obs, PokerPlayer const& player) override final {
+        if (obs.seat == 0 && obs.bet == 0.) return new_bet_action(ACTION_RAISE, player.index, 1.);
+        return new_bet_action(obs.bet == obs.seat_bet[obs.seat] ? ACTION_CHECK : ACTION_CALL, player.index);
+    }
+    virtual ControlResult discard(PokerObservation const& obs, PokerPlayer const& player) override final {
+        (void)obs;
+        player.hand.mark(0); player.hand.mark(1);
+        return CONTROL_OK;
+    }
+};
+
+static uint64_t bench_game(uint64_t n, size_t seats) {
+    PlayerList players;
+    for (size_t s = 0; s < seats; s++) players.add(new ScriptedPlayer(), 20.);
+    uint64_t acc = 0;
+    for (uint64_t h = 0; h < n; h++) {
+        for (auto& p : players) {p.hand = Deck::new_empty(); p.bet = 0.; p.in = true; p.stack = 20.;}
+        PokerGame game(players, 2, h + 1);
+        acc += game.run().winner->index;
+    }
+    bench_hands += n;
+    return acc;
+}
+static uint64_t bench_game_3(uint64_t n) {return bench_game(n, 3);}
+static uint64_t bench_game_6(uint64_t n) {return bench_game(n, 6);}
+
+static const Bench benches[] = {
+    {"deck_shuffle", bench_shuffle, false},
+    {"deck_seeded", bench_seeded, false},
+    {"deck_deal", bench_deal, false},
+    {"deck_minus", bench_deck_minus, false},
+    {"find_best_hand", bench_best_hand, false},
+    {"next_under", bench_next_under, false},
+    {"game_run_3", bench_game_3, true},
+    {"game_run_6", bench_game_6, true},
+};
+
+/**
+ *  harness
+ */
+
+static double run_ns(bench_f fn, uint64_t iters) {
+    auto start = std::chrono::steady_clock::now();
+    bench_sink = bench_sink + fn(iters);
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+static BenchResult measure(Bench const& b, size_t reps, double min_ms) {
+    /* grow the op count until one rep takes min_ms */
+    uint64_t iters = 1;
+    double ns = run_ns(b.fn, iters);
+    while (ns < min_ms * 1e6 && iters < (1ull << 40)) {
+        double want = ns > 0. ? (min_ms * 1e6 / ns) * (double)iters * 1.2 : (double)iters * 10.;
+        iters = std::max<uint64_t>(iters * 2, (uint64_t)want);
+        ns = run_ns(b.fn, iters);
+    }
+    std::vector<double> per_op;
+    for (size_t r = 0; r < reps; r++) per_op.push_back(run_ns(b.fn, iters) / (double)iters);
+    std::sort(per_op.begin(), per_op.end());
+    BenchResult res;
+    res.name = b.name;
+    res.iters = iters;
+    res.ns_per_op = per_op[per_op.size() / 2];
+    res.min_ns = per_op.front();
+    res.max_ns = per_op.back();
+    res.hands_per_sec = b.hands ? 1e9 / res.ns_per_op : 0.;
+    return res;
+}
+
+static void write_json(FILE* f, std::vector<BenchResult> const& results, size_t reps, double min_ms) {
+    fprintf(f, "{\"bench\":\"poker_bench\",\"version\":1,\"reps\":%zu,\"min_ms\":%.1f,\"results\":[\n", reps, min_ms);
+    for (size_t i = 0; i < results.size(); i++) {
+        BenchResult const& r = results[i];
+        fprintf(f, "  {\"name\":\"%s\",\"iters\":%lu,\"ns_per_op\":%.3f,\"ops_per_sec\":%.1f,\"min_ns\":%.3f,\"max_ns\":%.3f",
+                r.name.c_str(), (unsigned long)r.iters, r.ns_per_op, 1e9 / r.ns_per_op, r.min_ns, r.max_ns);
+        if (r.hands_per_sec > 0.) fprintf(f, ",\"hands_per_sec\":%.1f", r.hands_per_sec);
+        fprintf(f, "}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "]}\n");
+}
+
+/* only reads what write_json() writes: name and ns_per_op of each result */
+static bool read_baseline(const char* path, std::vector<BenchResult>& out) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {lg("ERROR: can't open baseline %s\n", path); return false;}
+    std::string text;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) text.append(buf, n);
+    fclose(f);
+    for (size_t at = text.find("\"name\":\""); at != std::string::npos; at = text.find("\"name\":\"", at)) {
+        at += 8;
+        size_t end = text.find('"', at);
+        size_t ns = text.find("\"ns_per_op\":", end);
+        if (end == std::string::npos || ns == std::string::npos) break;
+        BenchResult r{};
+        r.name = text.substr(at, end - at);
+        r.ns_per_op = strtod(text.c_str() + ns + 12, 0);
+        out.push_back(r);
+    }
+    if (out.empty()) {lg("ERROR: no results in baseline %s\n", path); return false;}
+    return true;
+}
+
+/* the table goes to stderr with the progress lines, stdout stays json */
+static int compare(std::vector<BenchResult> const& now, std::vector<BenchResult> const& base, double threshold) {
+    int regressions = 0;
+    fprintf(stderr, "%-16s %14s %14s %9s\n", "bench", "baseline ns", "now ns", "change");
+    for (auto const& r : now) {
+        auto it = std::find_if(base.begin(), base.end(), [&](BenchResult const& b) {return b.name == r.name;});
+        if (it == base.end() || it->ns_per_op <= 0.) {fprintf(stderr, "%-16s %14s %14.2f %9s\n", r.name.c_str(), "-", r.ns_per_op, "new"); continue;}
+        double change = r.ns_per_op / it->ns_per_op - 1.;
+        bool slow = change > threshold;
+        regressions += slow;
+        fprintf(stderr, "%-16s %14.2f %14.2f %+8.1f%%%s\n", r.name.c_str(), it->ns_per_op, r.ns_per_op, change * 100., slow ? "  REGRESSION" : "");
+    }
+    if (regressions) fprintf(stderr, "%d regression%s over %.0f%%\n", regressions, regressions == 1 ? "" : "s", threshold * 100.);
+    return regressions ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    size_t reps = 5;
+    double min_ms = 200., threshold = 0.10;
+    const char* filter = 0;
+    const char* out = 0;
+    const char* baseline = 0;
+    bool profile = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* val = i + 1 < argc ? argv[i+1] : 0;
+        if (!strcmp(arg, "-h") || !strcmp(arg, "--help")) {usage(); return 0;}
+        if (!strcmp(arg, "--profile")) {profile = true; continue;}
+        if (!val) {usage(); return 1;}
+        if      (!strcmp(arg, "--filter"))    filter = val;
+        else if (!strcmp(arg, "--reps"))      reps = strtoull(val, 0, 10);
+        else if (!strcmp(arg, "--min-ms"))    min_ms = atof(val);
+        else if (!strcmp(arg, "--out"))       out = val;
+        else if (!strcmp(arg, "--compare"))   baseline = val;
+        else if (!strcmp(arg, "--threshold")) threshold = atof(val);
+        else {usage(); return 1;}
+        i++;
+    }
+    if (!reps) reps = 1;
+
+    std::vector<BenchResult> base;
+    if (baseline && !read_baseline(baseline, base)) return 1;
+
+    if (profile) profile_start();
+    std::vector<BenchResult> results;
+    for (auto const& b : benches) {
+        if (filter && !strstr(b.name, filter)) continue;
+        /* progress on stderr, stdout stays clean json */
+        fprintf(stderr, "%s...\n", b.name);
+        results.push_back(measure(b, reps, min_ms));
+    }
+
+    FILE* f = out ? fopen(out, "w") : stdout;
+    if (!f) {lg("ERROR: can't write %s\n", out); return 1;}
+    write_json(f, results, reps, min_ms);
+    if (out) fclose(f);
+    /* stderr with the progress lines, stdout stays json */
+    if (profile) profile_report(bench_hands, stderr);
+    return baseline ? compare(results, base, threshold) : 0;
+}
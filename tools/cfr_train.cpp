@@ -0,0 +1,64 @@
+/**
+ * cfr_train.cpp
+ * poker
+ */
+#include <cstring>
+#include <cstdlib>
+#include <memory>
+#include "PokerCFR.h"
+
+static void usage() {
+    lg("usage: poker_cfr [--iters N] [--threads N] [--seats N] [--rounds N] [--stack X]\n"
+       "                 [--slots LOG2] [--every N] [--out FILE] [--resume FILE]\n");
+}
+
+int main(int argc, char** argv) {
+    uint64_t iters = 100000, every = 0;
+    size_t threads = 1, log2_slots = 22;
+    CfrGameConfig game;
+    const char* out = "cfr.bin";
+    const char* resume = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* val = i + 1 < argc ? argv[i+1] : 0;
+        if (!strcmp(arg, "-h") || !strcmp(arg, "--help")) {usage(); return 0;}
+        if (!val) {usage(); return 1;}
+        if      (!strcmp(arg, "--iters"))   iters = strtoull(val, 0, 10);
+        else if (!strcmp(arg, "--threads")) threads = strtoull(val, 0, 10);
+        else if (!strcmp(arg, "--seats"))   game.seats = (uint32_t)atoi(val);
+        else if (!strcmp(arg, "--rounds"))  game.rounds = (uint32_t)atoi(val);
+        else if (!strcmp(arg, "--stack"))   game.stack = atof(val);
+        else if (!strcmp(arg, "--slots"))   log2_slots = strtoull(val, 0, 10);
+        else if (!strcmp(arg, "--every"))   every = strtoull(val, 0, 10);
+        else if (!strcmp(arg, "--out"))     out = val;
+        else if (!strcmp(arg, "--resume"))  resume = val;
+        else {usage(); return 1;}
+        i++;
+    }
+    if (game.seats < 2 || game.seats > POKER_MAX_SEATS) {
+        lg("ERROR: --seats must be 2..%d\n", POKER_MAX_SEATS);
+        return 1;
+    }
+
+    std::unique_ptr<CfrTable> table(resume ? CfrTable::load(resume) : new CfrTable(log2_slots, game));
+    if (!table) return 1;
+    if (resume) {
+        lg("resumed %s: %lu iterations, %zu/%zu slots, %u seats %u rounds\n", resume,
+           (unsigned long)table->iterations, table->used(), table->size(), table->game.seats, table->game.rounds);
+    }
+
+    CfrTrainer trainer(*table, threads);
+    uint64_t chunk = every ? every : iters;
+    for (uint64_t done = 0; done < iters; ) {
+        uint64_t n = iters - done < chunk ? iters - done : chunk;
+        double rate = trainer.train(n);
+        done += n;
+        size_t used = table->used();
+        lg("%lu iterations, %.0f iterations/sec/core on %zu threads, %zu/%zu slots (%.1f%%)\n",
+           (unsigned long)table->iterations, rate, trainer.threads, used, table->size(), 100. * used / table->size());
+        if (!table->save(out)) return 1;
+    }
+    lg("wrote %s\n", out);
+    return 0;
+}
@@ -0,0 +1,435 @@
+/**
+ * sim.cpp
+ * poker
+ */
+#include <cstring>
+#include <cstdlib>
+#include <csignal>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include "PokerAI.h"
+#include "PokerCFR.h"
+#include "PokerDuplicate.h"
+#include "PokerLeague.h"
+#include "PokerPlugin.h"
+#include "PokerShard.h"
+#include "HandHistory.h"
+#include "HandReplay.h"
+#include "PokerInstrument.h"
+#include "Trace.h"
+#include "TextBuf.h"
+#include "AllocCount.h"
+#include "PokerProfile.h"
+#include "CardInstances.h"
+
+/**
+ * poker_sim: plays hands between RandomAIPlayers into a hand history file,
+ * reads one back and summarizes it, or replays it through the engine.
+ * --check runs the engine's settlement cases and the table's card instance layout.
+ * --duplicate compares bots by duplicate deals (PokerDuplicate.h), --league
+ * rates any number of them against each other (PokerLeague.h).
+ * --shard and --merge split a duplicate sweep over processes (PokerShard.h).
+ * plugin:PATH bots are shared objects (PokerPlugin.h), kill -HUP reloads
+ * the ones whose file changed without stopping the run.
+ */
+
+static void usage() {
+    lg("usage: poker_sim [--hands N] [--seats N] [--rounds N] [--seed N] --out FILE\n"
+       "       poker_sim --read FILE [--dump N]\n"
+       "       poker_sim --replay FILE [--threads N]\n"
+       "       poker_sim --check\n"
+       "       poker_sim --duplicate DEALS --bots random,mcts,cfr [--all-seatings] [--seed N] [--rounds N]\n"
+       "                 [--threads N] [--mcts-iters N] [--cfr FILE]\n"
+       "                 [--stop sprt|ci] [--confidence P] [--margin CHIPS] [--min-deals N]\n"
+       "                 [--shard I/N] [--out FILE]\n"
+       "       poker_sim --merge FILE... [--out FILE]\n"
+       "       poker_sim --league SECONDS --bots LIST [--matches N] [--match-deals N] [--threads N]\n"
+       "       bots are random, cfr, mcts, mcts:ITERS or plugin:PATH (kill -HUP reloads changed plugins)\n"
+       "       --stop ends a duplicate run once the first bot is significantly up or down,\n"
+       "       or within --margin chips a hand of even. DEALS is then the most it plays\n"
+       "       --shard plays block I (from 0) of N of the DEALS, --out writes its results for --merge,\n"
+       "       which reports any set of shards of one sweep as if it had run in one process\n"
+       "       --profile counts cycles, cache and branch misses and allocations per engine region\n"
+       "       any of them take --trace FILE in a POKER_TRACE build\n");
+}
+
+static int simulate(const char* out, uint64_t hands, size_t seats, size_t rounds, uint64_t seed) {
+    std::unique_ptr<HandHistoryWriter> writer(HandHistoryWriter::open(out));
+    if (!writer) return 1;
+    auto start = std::chrono::steady_clock::now();
+    uint64_t engine_allocs = 0;
+    for (uint64_t h = 0; h < hands; h++) {
+        PlayerList players;
+        for (size_t s = 0; s < seats; s++) players.add(new RandomAIPlayer(seed ? seed + h * seats + s : 0), 20.);
+        /* with --seed every hand deals from its own seed, so the log replays by seed alone */
+        PokerGame game(players, rounds, seed ? seed + h : 0);
+        game.recorder = writer.get();
+        /* only the hand itself, the first one warms up thread locals and the writer */
+        AllocCounts before = alloc_counts();
+        game.run();
+        if (h) engine_allocs += alloc_counts().allocs - before.allocs;
+    }
+    writer->flush();
+    if (alloc_counting())
+        lg("%lu global allocations inside %lu steady state hands\n", (unsigned long)engine_allocs, (unsigned long)(hands ? hands - 1 : 0));
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    lg("%lu hands, %lu bytes to %s in %.2fs (%.0f hands/sec)\n",
+       (unsigned long)writer->hands, (unsigned long)writer->bytes, out, secs, secs > 0. ? hands / secs : 0.);
+    return 0;
+}
+
+static int summarize(const char* path, uint64_t ndump) {
+    std::unique_ptr<HandHistoryReader> reader(HandHistoryReader::open(path));
+    if (!reader) return 1;
+    auto start = std::chrono::steady_clock::now();
+    TextBuf out;
+    uint64_t hands = 0, events = 0, actions[ACTION_LAST] = {0}, showdowns = 0, truncated = 0;
+    double pots = 0.;
+    for (HandView v : *reader) {
+        if (hands < ndump) v.print(out);
+        hands++;
+        pots += v.hand->pot;
+        events += v.hand->nevents;
+        truncated += (v.hand->flags & HH_TRUNCATED) != 0;
+        bool shown = false;
+        for (HandEvent const& e : v) {
+            if (e.type == HH_BET && e.kind < ACTION_LAST) actions[e.kind]++;
+            shown |= e.type == HH_SHOW;
+        }
+        showdowns += shown;
+    }
+    out.flush();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    lg("%s: %lu hands, %lu events, %zu bytes read in %.3fs\n", path, (unsigned long)hands, (unsigned long)events, reader->size_bytes(), secs);
+    if (!hands) return 0;
+    lg("avg pot %.2f, %.1f%% went to showdown\n", pots / hands, 100. * showdowns / hands);
+    if (truncated) lg("%lu hands ran past %d events and were cut short\n", (unsigned long)truncated, HH_MAX_EVENTS);
+    for (size_t a = 0; a < ACTION_LAST; a++)
+        lg("  %-5s %lu\n", action_name((pokerAction_e)a), (unsigned long)actions[a]);
+    return 0;
+}
+
+/* --bots names, --duplicate makes a fresh controller per seat per hand */
+struct SimBots {
+    const char* names[POKER_MAX_SEATS];
+    size_t n;
+    size_t mcts_iters;
+    std::unique_ptr<CfrTable> cfr;
+    PluginRegistry plugins;     /* by path */
+};
+
+static std::atomic<bool> reload_plugins{false};
+static void on_sighup(int) {reload_plugins.store(true);}
+
+static PokerPlayerController* make_bot(size_t bot, uint64_t seed, void* user) {
+    SimBots& bots = *(SimBots*)user;
+    const char* name = bots.names[bot];
+    if (reload_plugins.exchange(false)) lg("reloaded %zu plugins\n", bots.plugins.reload_changed());
+    if (!strncmp(name, "plugin:", 7)) return bots.plugins.make(name + 7, seed);
+    if (!strncmp(name, "mcts", 4)) {
+        MCTSConfig cfg;
+        cfg.iterations = name[4] == ':' ? strtoull(name + 5, 0, 10) : bots.mcts_iters;
+        cfg.seed = seed;
+        return new BasicAIPlayer(cfg);
+    }
+    if (!strcmp(name, "cfr")) return new CfrPlayer(*bots.cfr, seed);
+    return new RandomAIPlayer(seed);
+}
+
+/* the loaded build of a plugin bot, so a reload starts its league rating over */
+static uint32_t bot_build(size_t bot, void* user) {
+    SimBots& bots = *(SimBots*)user;
+    const char* name = bots.names[bot];
+    if (strncmp(name, "plugin:", 7)) return 0;
+    auto p = bots.plugins.get(name + 7);
+    return p ? p->generation : 0;
+}
+
+static bool parse_bots(char* list, SimBots& bots) {
+    bots.n = 0;
+    for (char* name = strtok(list, ","); name; name = strtok(0, ",")) {
+        if (bots.n == POKER_MAX_SEATS) {lg("ERROR: at most %d bots\n", POKER_MAX_SEATS); return false;}
+        bool mcts = !strcmp(name, "mcts") || (!strncmp(name, "mcts:", 5) && atoi(name + 5) > 0);
+        bool plugin = !strncmp(name, "plugin:", 7);
+        if (strcmp(name, "random") && !mcts && strcmp(name, "cfr") && !plugin) {
+            lg("ERROR: unknown bot %s, pick random, mcts, mcts:ITERS, cfr or plugin:PATH\n", name);
+            return false;
+        }
+        if (plugin && !bots.plugins.get(name + 7) && !bots.plugins.load(name + 7, name + 7)) return false;
+        if (plugin) signal(SIGHUP, on_sighup);
+        if (!strcmp(name, "cfr") && !bots.cfr) {lg("ERROR: cfr bots need --cfr FILE\n"); return false;}
+        bots.names[bots.n++] = name;
+    }
+    return true;
+}
+
+static int duplicate(DuplicateConfig cfg, SimBots& bots, uint64_t sweep, const char* out, uint64_t* done) {
+    std::unique_ptr<ShardWriter> writer;
+    if (out) {
+        writer.reset(ShardWriter::open(out, cfg, sweep, bots.names));
+        if (!writer) return 1;
+        cfg.on_result = ShardWriter::on_result;
+        cfg.result_user = writer.get();
+    }
+    DuplicateStats st = run_duplicate(cfg, make_bot, &bots);
+    *done = st.hands;
+    if (!st.deals) return 1;
+    if (writer && !writer->finish(st)) return 1;
+    st.report(bots.names);
+    return 0;
+}
+
+static int merge(std::vector<const char*> const& paths, const char* out) {
+    ShardFile all;
+    if (!merge_shards(paths.data(), paths.size(), all, out)) return 1;
+    const char* names[POKER_MAX_SEATS];
+    for (size_t b = 0; b < POKER_MAX_SEATS; b++) names[b] = all.head.names[b][0] ? all.head.names[b] : 0;
+    lg("merged %zu files: %lu of %lu deals", paths.size(), (unsigned long)all.head.deals, (unsigned long)all.head.sweep_deals);
+    if (all.head.deals != all.head.sweep_deals) {
+        lg(", have");
+        for (auto const& r : all.ranges) lg(" %lu-%lu", (unsigned long)r.first, (unsigned long)r.end - 1);
+    }
+    lg("\n");
+    if (all.head.deals) all.stats().report(names);
+    return 0;
+}
+
+static int league(LeagueConfig const& cfg, SimBots& bots, uint64_t* done) {
+    League l(cfg);
+    for (size_t b = 0; b < bots.n; b++) l.add(bots.names[b], make_bot, &bots, bot_build);
+    l.run();
+    *done = 0;
+    for (auto const& b : l.bots) *done += b.deals;
+    return 0;
+}
+
+static int replay(const char* path, size_t threads, uint64_t* done) {
+    std::unique_ptr<HandHistoryReader> reader(HandHistoryReader::open(path));
+    if (!reader) return 1;
+    ReplayStats st = replay_corpus(*reader, threads);
+    *done = st.hands;
+    lg("replayed %lu hands (%lu events) on %zu threads in %.2fs, %.0f hands/sec, %lu mismatches\n",
+       (unsigned long)st.hands, (unsigned long)st.events, threads, st.seconds, st.hands_per_sec(), (unsigned long)st.mismatches);
+    return st.mismatches ? 2 : 0;
+}
+
+/* settle_pots() against pots worked out by hand. returns how many cases failed */
+struct SettleCase {
+    const char* name;
+    size_t n;
+    Money contrib[POKER_MAX_SEATS];
+    bool in[POKER_MAX_SEATS];
+    uint32_t strength[POKER_MAX_SEATS];
+    Money want[POKER_MAX_SEATS];
+    size_t best;
+};
+
+static const SettleCase settle_cases[] = {
+    /* seat 0 all in short, 1 beats 2 for the side pot */
+    {"main and side pot", 3, {5., 10., 10.}, {true, true, true}, {3, 2, 1}, {15., 10., 0.}, 0},
+    /* 0 and 1 split the main pot, 1 alone covered the side pot */
+    {"tie on the main pot only", 3, {5., 10., 10.}, {true, true, true}, {2, 2, 1}, {7.5, 17.5, 0.}, 0},
+    {"three way split", 3, {10., 10., 10.}, {true, true, true}, {4, 4, 4}, {10., 10., 10.}, 0},
+    /* what 2 and 3 put in before folding goes to 1 */
+    {"dead money", 4, {10., 10., 2., 6.}, {true, true, false, false}, {1, 3, 0, 0}, {0., 28., 0., 0.}, 1},
+    /* the folded seat's chips fill both the main and the side pot */
+    {"dead money in a side pot", 3, {5., 10., 10.}, {true, true, false}, {3, 2, 0}, {15., 10., 0.}, 0},
+    /* folded above every live seat, the rest goes to the best hand */
+    {"dead money over the live seats", 2, {4., 10.}, {true, false}, {1, 0}, {14., 0.}, 0},
+};
+
+static int check_settle() {
+    int failed = 0;
+    for (SettleCase const& c : settle_cases) {
+        Money won[POKER_MAX_SEATS];
+        size_t best = settle_pots(c.n, c.contrib, c.in, c.strength, won);
+        bool ok = best == c.best;
+        for (size_t i = 0; i < c.n; i++) ok &= won[i] == c.want[i];
+        if (ok) {lg("PASS: settle_pots %s\n", c.name); continue;}
+        failed++;
+        lg("ERROR: settle_pots %s: best %zu (want %zu), won", c.name, best, c.best);
+        for (size_t i = 0; i < c.n; i++) lg(" %.2f (want %.2f)", (double)won[i], (double)c.want[i]);
+        nl();
+    }
+    return failed;
+}
+
+static void check_case(int& failed, bool ok, const char* name) {
+    if (ok) {lg("PASS: %s\n", name); return;}
+    failed++;
+    lg("ERROR: %s\n", name);
+}
+
+/* table_pile_instances() and card_sheet_cell(), no gl needed. returns how many cases failed */
+static int check_card_instances() {
+    int failed = 0;
+    /* the layout table in the README, a row per suit under the backs and rank columns ace first */
+    static const char* sheet_ranks = "A23456789TJQK";
+    static const char* sheet_suits = "hdsc";
+    for (size_t row = 1; row <= 4; row++) {
+        bool ok = true;
+        for (size_t col = 0; col < 13; col++) {
+            char text[CARD_TEXT_LEN] = {sheet_ranks[col], sheet_suits[row - 1]};
+            Card card;
+            SheetCell cell = card_parse(text, card) ? card_sheet_cell(card) : SheetCell{0xFF, 0xFF};
+            ok &= cell.x == col && cell.y == row;
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "card_sheet_cell row %zu is %s", row, suit_name((suit_e)(row - 1)));
+        check_case(failed, ok, name);
+    }
+
+    /* 3 seats mid hand, seat 1 watching, seat 2 on 3 cards, 20 left in the deck */
+    TableSnapshot t;
+    memset(&t, 0, sizeof(t));
+    t.nseats = 3;
+    t.state = PokerFSM::BET_CHECK;
+    t.ndeck = 20;
+    for (size_t s = 0; s < 3; s++) {
+        t.ncards[s] = s == 2 ? 3 : 5;
+        for (size_t i = 0; i < t.ncards[s]; i++) t.cards[s][i] = (uint8_t)(s * 5 + i);
+    }
+    TableLayout at;
+    at.viewer = 1;
+    CardInstance out[TABLE_SLOTS];
+    for (size_t pile = 0; pile <= POKER_PILE_DECK; pile++) table_pile_instances(t, pile, at, out + table_pile_first(pile));
+
+    bool up = true, down = true;
+    for (size_t i = 0; i < 5; i++) {
+        up &= out[table_pile_first(1) + i].face == CARD_FACE_UP;
+        down &= out[table_pile_first(0) + i].face == CARD_FACE_DOWN;
+    }
+    for (size_t i = 0; i < 3; i++) down &= out[table_pile_first(2) + i].face == CARD_FACE_DOWN;
+    check_case(failed, up && down, "table_pile_instances only the viewer's cards face up");
+    check_case(failed, out[table_pile_first(1)].y < at.y && out[table_pile_first(0)].y >= at.y - 0.001f,
+               "table_pile_instances viewer at the bottom");
+    Card c7 = card_from_index(7);
+    SheetCell cell7 = card_sheet_cell(c7);
+    check_case(failed, out[table_pile_first(1) + 2].cellx == cell7.x && out[table_pile_first(1) + 2].celly == cell7.y,
+               "table_pile_instances seat cards in hand order");
+
+    bool hidden = true;
+    for (size_t i = 5; i < TABLE_SEAT_CARDS; i++) hidden &= out[table_pile_first(0) + i].face == CARD_HIDDEN;
+    for (size_t i = 3; i < TABLE_SEAT_CARDS; i++) hidden &= out[table_pile_first(2) + i].face == CARD_HIDDEN;
+    for (size_t pile = 3; pile < POKER_MAX_SEATS; pile++)
+        for (size_t i = 0; i < TABLE_SEAT_CARDS; i++) hidden &= out[table_pile_first(pile) + i].face == CARD_HIDDEN;
+    for (size_t i = 0; i < TABLE_DECK_SLOTS; i++)
+        hidden &= out[table_pile_first(POKER_PILE_DECK) + i].face == (i < t.ndeck ? CARD_FACE_DOWN : CARD_HIDDEN);
+    check_case(failed, hidden, "table_pile_instances unused slots CARD_HIDDEN");
+
+    /* at showdown the cards a seat shows turn up too */
+    t.state = PokerFSM::SHOW;
+    t.cards[0][1] |= TABLE_CARD_MARKED;
+    table_pile_instances(t, 0, at, out);
+    check_case(failed, out[1].face == CARD_FACE_UP && out[0].face == CARD_FACE_DOWN, "table_pile_instances shown cards face up");
+
+    bool ranges = table_pile_first(POKER_PILE_DECK) + table_pile_slots(POKER_PILE_DECK) == TABLE_SLOTS;
+    for (size_t pile = 0; pile < POKER_PILE_DECK; pile++)
+        ranges &= table_pile_first(pile) + table_pile_slots(pile) == table_pile_first(pile + 1);
+    check_case(failed, ranges, "table_pile_first/slots ranges tile TABLE_SLOTS");
+    return failed;
+}
+
+int main(int argc, char** argv) {
+    uint64_t hands = 10000, seed = 0, ndump = 0;
+    size_t seats = 3, rounds = 2, threads = 1;
+    const char* out = 0;
+    const char* read = 0;
+    const char* replay_path = 0;
+    bool profile = false;
+    bool duplicating = false, leaguing = false;
+    DuplicateConfig dup;
+    uint64_t sweep = 0;
+    LeagueConfig lc;
+    std::string bot_list = "random,random";
+    uint32_t shard = 0, shards = 1;
+    std::vector<const char*> merging;
+    SimBots bots;
+    bots.mcts_iters = 200;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* val = i + 1 < argc ? argv[i+1] : 0;
+        if (!strcmp(arg, "-h") || !strcmp(arg, "--help")) {usage(); return 0;}
+        if (!strcmp(arg, "--profile")) {profile = true; continue;}
+        if (!strcmp(arg, "--check")) return check_settle() + check_card_instances() ? 1 : 0;
+        if (!strcmp(arg, "--all-seatings")) {dup.all_seatings = true; continue;}
+        if (!strcmp(arg, "--merge")) {
+            while (i + 1 < argc && strncmp(argv[i+1], "--", 2)) merging.push_back(argv[++i]);
+            continue;
+        }
+        if (!val) {usage(); return 1;}
+        if      (!strcmp(arg, "--hands"))  hands = strtoull(val, 0, 10);
+        else if (!strcmp(arg, "--seats"))  seats = strtoull(val, 0, 10);
+        else if (!strcmp(arg, "--rounds")) rounds = strtoull(val, 0, 10);
+        else if (!strcmp(arg, "--seed"))   seed = strtoull(val, 0, 10);
+        else if (!strcmp(arg, "--dump"))   ndump = strtoull(val, 0, 10);
+        else if (!strcmp(arg, "--out"))    out = val;
+        else if (!strcmp(arg, "--read"))   read = val;
+        else if (!strcmp(arg, "--replay")) replay_path = val;
+        else if (!strcmp(arg, "--threads")) threads = strtoull(val, 0, 10);
+        else if (!strcmp(arg, "--trace"))  {trace_start(val); trace_thread_name("main");}
+        else if (!strcmp(arg, "--duplicate")) {duplicating = true; dup.deals = strtoull(val, 0, 10);}
+        else if (!strcmp(arg, "--bots"))   bot_list = val;
+        else if (!strcmp(arg, "--shard")) {
+            if (sscanf(val, "%u/%u", &shard, &shards) != 2 || shard >= shards) {lg("ERROR: --shard is I/N with I < N\n"); return 1;}
+        }
+        else if (!strcmp(arg, "--league")) {leaguing = true; lc.seconds = atof(val);}
+        else if (!strcmp(arg, "--matches"))     lc.max_matches = strtoull(val, 0, 10);
+        else if (!strcmp(arg, "--match-deals")) lc.match_deals = strtoull(val, 0, 10);
+        else if (!strcmp(arg, "--mcts-iters")) bots.mcts_iters = strtoull(val, 0, 10);
+        else if (!strcmp(arg, "--cfr"))    bots.cfr.reset(CfrTable::load(val));
+        else if (!strcmp(arg, "--stop")) {
+            if      (!strcmp(val, "sprt")) dup.stop.rule = STOP_SPRT;
+            else if (!strcmp(val, "ci"))   dup.stop.rule = STOP_CI;
+            else {usage(); return 1;}
+        }
+        else if (!strcmp(arg, "--confidence")) dup.stop.confidence = atof(val);
+        else if (!strcmp(arg, "--margin"))     dup.stop.margin = atof(val);
+        else if (!strcmp(arg, "--min-deals"))  dup.stop.min_samples = strtoull(val, 0, 10);
+        else {usage(); return 1;}
+        i++;
+    }
+    if (read) return summarize(read, ndump);
+    if (!merging.empty()) return merge(merging, out);
+    if (leaguing) {
+        if (!parse_bots(bot_list.data(), bots)) return 1;
+        lc.rounds = rounds;
+        lc.threads = threads;
+        if (seed) lc.seed = seed;
+        if (!lc.match_deals) {usage(); return 1;}
+    } else if (duplicating) {
+        /* names point into bot_list from here on */
+        if (!parse_bots(bot_list.data(), bots)) return 1;
+        if (dup.stop.rule == STOP_SPRT && dup.stop.margin <= 0.) {lg("ERROR: --stop sprt needs a --margin\n"); return 1;}
+        if (dup.stop.confidence <= 0.5 || dup.stop.confidence >= 1.) {lg("ERROR: --confidence is in (0.5, 1)\n"); return 1;}
+        if (out && dup.stop.rule != STOP_NONE) {lg("ERROR: shard results need every deal, no --stop\n"); return 1;}
+        dup.bots = bots.n;
+        dup.rounds = rounds;
+        dup.threads = threads;
+        if (seed) dup.seed = seed;
+        sweep = dup.deals;
+        shard_deals(sweep, shard, shards, &dup.first, &dup.deals);
+    }
+    if (profile) profile_start();
+    int res;
+    uint64_t done = hands;
+    if (leaguing) {
+        res = league(lc, bots, &done);
+    } else if (duplicating) {
+        res = duplicate(dup, bots, sweep, out, &done);
+    } else if (replay_path) {
+        res = replay(replay_path, threads, &done);
+    } else {
+        if (!out || seats < 2 || seats > POKER_MAX_SEATS) {usage(); return 1;}
+        res = simulate(out, hands, seats, rounds, seed);
+    }
+    if (profile) profile_report(done);
+#ifdef POKER_INSTRUMENT
+    instrument_report();
+#endif
+    return res;
+}